@@ -1,5 +1,173 @@
 #include "multithreading.h"
 
+/**
+ * struct direct_taps_s - Non-zero taps of a compiled kernel, laid out for
+ * the direct convolution of one image
+ * @offs: offset of every tap, in pixels, relative to the output pixel
+ * @w:    weight of every tap, in kernel row-major order
+ * @n:    number of taps
+ * @sum:  sum of all the weights, accumulated in the same order as @w
+ * @acc:  one RGB float triplet per column of the portion
+ */
+
+typedef struct direct_taps_s
+{
+	long *offs;
+	float const *w;
+	size_t n;
+	float sum;
+	float *acc;
+} direct_taps_t;
+
+/**
+ * blur_pixels_checked - program that blurs pixels of a row close to the
+ * borders of the image
+ * every tap is checked against the image bounds, and the taps falling
+ * outside of the image are left out of both the weighted sum and the
+ * total weight
+ * @portion: a pointer to the portion of the image to blur
+ * @y: the row of the pixels to blur
+ * @from: the first column to blur
+ * @to: the column past the last column to blur
+ * Return: nothing (void)
+ */
+
+static void blur_pixels_checked(blur_portion_t const *portion, size_t y,
+				size_t from, size_t to)
+{
+	size_t x, kx, ky, size = portion->kernel->size;
+	size_t W = portion->img->w, H = portion->img->h;
+	long pixel_x, pixel_y;
+	float weight;
+	pixel_t current_pixel, *blurred_pixel;
+
+	for (x = from; x < to; x++)
+	{
+		float totalR = 0, totalG = 0, totalB = 0, totalWeight = 0;
+
+		for (ky = 0; ky < size; ky++)
+		{
+			pixel_y = (long)(y + ky) - (long)(size / 2);
+			for (kx = 0; kx < size; kx++)
+			{
+				pixel_x = (long)(x + kx) - (long)(size / 2);
+				if (pixel_x < 0 || pixel_x >= (long)W ||
+				    pixel_y < 0 || pixel_y >= (long)H)
+					continue;
+				current_pixel = portion->img->pixels
+					[pixel_y * portion->img->w + pixel_x];
+				weight = portion->kernel->matrix[ky][kx];
+				totalR += current_pixel.r * weight;
+				totalG += current_pixel.g * weight;
+				totalB += current_pixel.b * weight;
+				totalWeight += weight;
+			}
+		}
+		blurred_pixel = portion->img_blur->pixels +
+				y * portion->img_blur->w + x;
+		blurred_pixel->r = totalR / totalWeight;
+		blurred_pixel->g = totalG / totalWeight;
+		blurred_pixel->b = totalB / totalWeight;
+	}
+}
+
+/**
+ * blur_pixels_interior - program that blurs pixels of a row whose taps
+ * all fall inside the image
+ * the taps are accumulated by the vectorized convolution span, and the
+ * total weight is the precomputed sum of the kernel
+ * @portion: a pointer to the portion of the image to blur
+ * @taps: a pointer to the flattened kernel
+ * @y: the row of the pixels to blur
+ * @from: the first column to blur
+ * @to: the column past the last column to blur
+ * Return: nothing (void)
+ */
+
+static void blur_pixels_interior(blur_portion_t const *portion,
+				 direct_taps_t const *taps, size_t y,
+				 size_t from, size_t to)
+{
+	pixel_t *dst = portion->img_blur->pixels + y * portion->img_blur->w;
+	float const *acc = taps->acc;
+	size_t x;
+
+	blur_conv_span(portion->img->pixels + y * portion->img->w + from,
+		       taps->offs, taps->w, taps->n, to - from, taps->acc);
+	for (x = from; x < to; x++, acc += 3)
+	{
+		dst[x].r = acc[0] / taps->sum;
+		dst[x].g = acc[1] / taps->sum;
+		dst[x].b = acc[2] / taps->sum;
+	}
+}
+
+/**
+ * blur_portion_direct - program that blurs a portion of an image with a
+ * direct 2D convolution
+ * every non-zero tap of the kernel is visited for every pixel of the
+ * portion; the rows and columns whose taps all fall inside the image go
+ * through the vectorized convolution span, the pixels close to the
+ * borders are handled one tap at a time
+ * @portion: a pointer to the portion of the image to blur
+ * @ck: a pointer to the compiled kernel
+ * Return: nothing (void)
+ */
+
+static void blur_portion_direct(blur_portion_t const *portion,
+				ckernel_t const *ck)
+{
+	size_t size = ck->size, r = size / 2, i, y, xa, xb;
+	size_t end_x = portion->x + portion->w, W = portion->img->w;
+	direct_taps_t taps;
+
+	taps.n = ck->ntaps, taps.w = ck->tap_w, taps.sum = ck->sum;
+	taps.offs = malloc(sizeof(long) * taps.n +
+			   sizeof(float) * portion->w * 3);
+	xa = portion->x > r ? portion->x : r;
+	xb = W > size - 1 - r ? W - (size - 1 - r) : 0;
+	xb = xb < end_x ? xb : end_x;
+	if (!taps.offs || xa >= xb)
+		xa = xb = end_x;
+	taps.acc = (float *)(taps.offs + taps.n);
+	for (i = 0; taps.offs && i < taps.n; i++)
+		taps.offs[i] = ck->tap_y[i] * (long)W + ck->tap_x[i];
+	for (y = portion->y; y < portion->y + portion->h; y++)
+	{
+		if (y < r || y + size - 1 - r >= portion->img->h)
+		{
+			blur_pixels_checked(portion, y, portion->x, end_x);
+			continue;
+		}
+		blur_pixels_checked(portion, y, portion->x, xa);
+		if (xa < xb)
+			blur_pixels_interior(portion, &taps, y, xa, xb);
+		blur_pixels_checked(portion, y, xb, end_x);
+	}
+	free(taps.offs);
+}
+
+/**
+ * blur_portion_ck - program that blurs a portion of an image with a
+ * compiled kernel
+ * separable kernels are blurred with a horizontal pass followed by a
+ * vertical pass, other kernels (or a failed allocation of the
+ * intermediate buffer) with the direct convolution; the taps falling
+ * outside of the image are dropped and the weights renormalized
+ * @portion: a pointer to the portion of the image to blur;
+ *           portion->kernel must hold the same weights as ck
+ * @ck: a pointer to the compiled kernel
+ * Return: nothing (void)
+ */
+
+void blur_portion_ck(blur_portion_t const *portion, ckernel_t const *ck)
+{
+	if (ck->separable &&
+	    blur_portion_separable(portion, ck->row, ck->col, ck->size))
+		return;
+	blur_portion_direct(portion, ck);
+}
+
 /**
  * blur_portion - program that applies a Gaussian blur to a specified portion
  * of an image
@@ -13,7 +181,12 @@
  * portion of the image, resulting in a blurred effect;
  * the function handles boundary conditions and ensures that pixel
  * manipulations stay within the bounds of the image;
- * the resultant blurred image is stored in img_blur
+ * the resultant blurred image is stored in img_blur;
+ * the kernel is compiled once per thread and reused as long as the
+ * thread passes the same weights, see kernel_cached and blur_portion_ck;
+ * separable kernels (such as Gaussian kernels) are blurred with a
+ * horizontal pass followed by a vertical pass, which costs O(2K) per
+ * pixel instead of O(K^2)
  * @portion: a pointer to a 'blur_portion_t' structure.
  *           This structure includes all necessary information:
  *           - img: a pointer to the original image (img_t)
@@ -29,44 +202,15 @@
 
 void blur_portion(blur_portion_t const *portion)
 {
-	size_t end_x = portion->x + portion->w, end_y = portion->y + portion->h;
-	size_t x, y;
-	float weight;
-	size_t kx, ky;
-	int pixel_x, pixel_y, adjusted_kx, adjusted_ky;
-	pixel_t current_pixel, *blurred_pixel;
+	ckernel_t const *ck = kernel_cached(portion->kernel);
+	size_t y;
 
-	for (y = portion->y; y < end_y; y++)
+	if (!ck)
 	{
-		for (x = portion->x; x < end_x; x++)
-		{
-			float totalR = 0, totalG = 0, totalB = 0, totalWeight = 0;
-
-			for (ky = 0; ky < portion->kernel->size; ky++)
-			{
-				adjusted_ky = ky - portion->kernel->size / 2;
-				for (kx = 0; kx < portion->kernel->size; kx++)
-				{
-					adjusted_kx = kx - portion->kernel->size / 2;
-					pixel_x = x + adjusted_kx;
-					pixel_y = y + adjusted_ky;
-					if (pixel_x >= 0 && pixel_x < (int)portion->img->w &&
-					pixel_y >= 0 && pixel_y < (int)portion->img->h)
-					{
-						current_pixel = portion->img->pixels
-							[pixel_y * portion->img->w + pixel_x];
-						weight = portion->kernel->matrix[ky][kx];
-						totalR += current_pixel.r * weight;
-						totalG += current_pixel.g * weight;
-						totalB += current_pixel.b * weight;
-						totalWeight += weight;
-					}
-				}
-			}
-			blurred_pixel = &portion->img_blur->pixels[y * portion->img_blur->w + x];
-			blurred_pixel->r = totalR / totalWeight;
-			blurred_pixel->g = totalG / totalWeight;
-			blurred_pixel->b = totalB / totalWeight;
-		}
+		for (y = portion->y; y < portion->y + portion->h; y++)
+			blur_pixels_checked(portion, y, portion->x,
+					    portion->x + portion->w);
+		return;
 	}
+	blur_portion_ck(portion, ck);
 }
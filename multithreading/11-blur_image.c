@@ -1,10 +1,9 @@
 #include "multithreading.h"
 
-#define THREAD_POOL_SZ 10
-
 /**
  * blurPortionThreadEntry - thread entry program to blur a portion
  * of an image
+ * the portion is blurred with the edge mode it carries;
  * this function exits the thread if the input portion is NULL
  * @portion: a pointer to a blur_portion_t structure containing image
  *           data to blur
@@ -16,7 +15,7 @@ void *blurPortionThreadEntry(blur_portion_t *portion)
 	if (!portion)
 		pthread_exit(NULL);
 
-	blur_portion(portion);
+	blur_portion_edge(portion, portion->edge);
 
 	pthread_exit(NULL);
 }
@@ -67,6 +66,7 @@ blur_portion_t *portionImage(img_t *img_blur, const img_t *img,
 		}
 
 		portions[i].kernel = kernel;
+		portions[i].edge = EDGE_RENORMALIZE;
 
 		next_y += portions[i].h;
 	}
@@ -75,58 +75,69 @@ blur_portion_t *portionImage(img_t *img_blur, const img_t *img,
 }
 
 /**
- * blur_image - program that blurs an entire image using multithreading
- * by dividing the image into smaller portions
- * the function uses a thread pool to process each portion concurrently
+ * blur_image_opts - program that blurs an entire image using
+ * multithreading, with explicit options
+ * the kernel is compiled once for the call, see blur_image_ck
  * @img_blur: a pointer to the output image data structure
  * @img: a pointer to the input image data structure
  * @kernel: a pointer to the convolution kernel used for blurring
+ * @opts: a pointer to the blur options, NULL for the defaults
  * Return: nothing (void)
  */
 
-void blur_image(img_t *img_blur, img_t const *img, kernel_t const *kernel)
+void blur_image_opts(img_t *img_blur, img_t const *img,
+		     kernel_t const *kernel, blur_opts_t const *opts)
 {
-	pthread_t t_ids[THREAD_POOL_SZ] = {0};
-	blur_portion_t *portions = NULL;
-	pthread_attr_t attr;
-	size_t i, j;
+	ckernel_t *ck = NULL;
 
 	if (!img_blur || !img || !kernel ||
 	    !img_blur->pixels || !img->pixels || !kernel->matrix)
 		return;
 
-	pthread_attr_init(&attr);
-	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-	portions = portionImage(img_blur, img, kernel, THREAD_POOL_SZ);
+	ck = kernel_compile(kernel);
 
-	if (!portions)
+	if (!ck)
 	{
-		fprintf(stderr, "blur_image: portionImage failed\n");
+		fprintf(stderr, "blur_image: kernel_compile failed\n");
 		return;
 	}
-	for (i = 0; i < THREAD_POOL_SZ; i++)
-	{
-		if (pthread_create(t_ids + i, &attr,
-				   (void *(*)(void *))blurPortionThreadEntry,
-				   portions + i) != 0)
-		{
-			fprintf(stderr, "blur_image: pthread_create failed\n");
-			for (j = 0; j < i; j++)
-				pthread_kill(t_ids[j], SIGTERM);
-			free(portions);
-			return;
-		}
-	}
-	pthread_attr_destroy(&attr);
+	blur_image_ck(img_blur, img, ck, opts);
+	kernel_free(ck);
+}
 
-	for (i = 0; i < THREAD_POOL_SZ; i++)
-	{
-		if (pthread_join(t_ids[i], NULL) != 0)
-		{
-			fprintf(stderr, "blur_image: pthread_join failed\n");
-			free(portions);
-			return;
-		}
-	}
-	free(portions);
+/**
+ * blur_image_edge - program that blurs an entire image using
+ * multithreading, with a selectable behavior at the borders of the image
+ * @img_blur: a pointer to the output image data structure
+ * @img: a pointer to the input image data structure
+ * @kernel: a pointer to the convolution kernel used for blurring
+ * @mode: the edge mode, see blur_portion_edge
+ * Return: nothing (void)
+ */
+
+void blur_image_edge(img_t *img_blur, img_t const *img,
+		     kernel_t const *kernel, edge_mode_t mode)
+{
+	blur_opts_t opts = {EDGE_RENORMALIZE, 0, 0, 0, 0};
+
+	opts.edge = mode;
+	blur_image_opts(img_blur, img, kernel, &opts);
+}
+
+/**
+ * blur_image - program that blurs an entire image using multithreading
+ * by dividing the image into smaller portions
+ * the function uses the blur pool to process tiles of the image
+ * concurrently;
+ * the taps falling outside of the image are dropped and the remaining
+ * weights renormalized
+ * @img_blur: a pointer to the output image data structure
+ * @img: a pointer to the input image data structure
+ * @kernel: a pointer to the convolution kernel used for blurring
+ * Return: nothing (void)
+ */
+
+void blur_image(img_t *img_blur, img_t const *img, kernel_t const *kernel)
+{
+	blur_image_edge(img_blur, img, kernel, EDGE_RENORMALIZE);
 }
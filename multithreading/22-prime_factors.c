@@ -4,7 +4,7 @@ static pthread_mutex_t task_status_mutex;
 
 /**
  * initTaskStatusMutex - program that initializes the mutex
- * used to manage access to the status of tasks
+ * handed to every task as its lock; exec_tasks claims the tasks without it
  * Return: nothing (void)
  */
 
@@ -50,6 +50,11 @@ task_t *create_task(task_entry_t entry, void *param)
 	task->status = PENDING;  /* Initial status is set to PENDING */
 	task->result = NULL;
 	task->lock = task_status_mutex;
+	task->futex = 0;
+	task->deps = 1;  /* Released by task_submit */
+	task->npred = 0;
+	task->succ = NULL;
+	task->nsucc = 0;
 
 	return (task);
 }
@@ -72,12 +77,21 @@ void destroy_task(task_t *task)
 		free(task->result);
 	}
 
+	free(task->succ);
 	free(task);
 }
 
 /**
  * exec_tasks - program that executes all tasks in a given list,
  * managing each task's state
+ * every thread running exec_tasks over the same list walks it once and
+ * claims the tasks still PENDING with an atomic compare-and-swap of their
+ * status to STARTED, so no lock is shared between the threads; a relaxed
+ * load skips the tasks already claimed without writing their cache line;
+ * the result is published through future_complete, which wakes up the
+ * threads waiting for the task; exec_tasks knows nothing of the
+ * dependencies of task_depend, so the tasks that have predecessors are
+ * skipped and left PENDING rather than run out of order
  * @tasks: a pointer to a list of tasks to be executed
  * Return: NULL always (used for compatibility with threading functions)
  */
@@ -86,6 +100,8 @@ void *exec_tasks(list_t const *tasks)
 {
 	node_t *curr_node = NULL;
 	task_t *task = NULL;
+	task_status_t pending;
+	void *result;
 	size_t i;
 
 	if (!tasks || !tasks->head)
@@ -95,32 +111,20 @@ void *exec_tasks(list_t const *tasks)
 	     i++, curr_node = curr_node->next)
 	{
 		task = (task_t *)curr_node->content;
-
-		if (!task)
+		pending = PENDING;
+
+		if (!task || task->npred ||
+		    __atomic_load_n(&task->status,
+				    __ATOMIC_RELAXED) != pending ||
+		    !__atomic_compare_exchange_n(&task->status, &pending,
+						 STARTED, 0, __ATOMIC_ACQUIRE,
+						 __ATOMIC_RELAXED))
 			continue;
 
-		pthread_mutex_lock(&task_status_mutex);
-		if (task->status == PENDING)
-		{
-			task->status = STARTED;
-			pthread_mutex_unlock(&task_status_mutex);
-
-			tprintf("[%02lu] Started\n", i);
-			task->result = task->entry(task->param);
-
-			if (!task->result)
-			{
-				task->status = FAILURE;
-				tprintf("[%02lu] Failure\n", i);
-			}
-			else
-			{
-				task->status = SUCCESS;
-				tprintf("[%02lu] Success\n", i);
-			}
-		}
-		else
-			pthread_mutex_unlock(&task_status_mutex);
+		tprintf("[%02lu] Started\n", i);
+		result = task->entry(task->param);
+		future_complete(task, result);
+		tprintf("[%02lu] %s\n", i, result ? "Success" : "Failure");
 	}
 
 	return (NULL);
@@ -0,0 +1,67 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "multithreading.h"
+
+/**
+ * enum bench_backend_e - Blur entry points timed by the benchmark
+ * @BENCH_PORTION: blur_portion over the whole image, on the calling thread
+ * @BENCH_TILES:   blur_image, tiles on the blur pool
+ * @BENCH_FIXED:   blur_image_opts in fixed point
+ * @BENCH_PLANAR:  blur_image_opts through the planar layout
+ * @BENCH_BOX:     blur_box with the radius of the kernel
+ * @BENCH_COUNT:   Number of backends
+ */
+
+typedef enum bench_backend_e
+{
+    BENCH_PORTION = 0,
+    BENCH_TILES,
+    BENCH_FIXED,
+    BENCH_PLANAR,
+    BENCH_BOX,
+    BENCH_COUNT
+} bench_backend_t;
+
+/**
+ * enum bench_shape_e - Shapes of the synthetic kernels
+ * @BENCH_GAUSSIAN:    Isotropic Gaussian, separable
+ * @BENCH_ANISOTROPIC: Rotated elongated Gaussian, not separable, so the
+ *                     direct 2D and FFT paths are timed too
+ */
+
+typedef enum bench_shape_e
+{
+    BENCH_GAUSSIAN = 0,
+    BENCH_ANISOTROPIC
+} bench_shape_t;
+
+/**
+ * struct bench_point_s - One point of the benchmark grid
+ * @backend: Blur entry point
+ * @img:     Synthetic source image
+ * @out:     Destination image, of the size of @img
+ * @kernel:  Synthetic kernel
+ * @shape:   Shape of @kernel
+ * @threads: Number of blur workers, the caller included
+ * @reps:    Number of timed calls
+ */
+
+typedef struct bench_point_s
+{
+    bench_backend_t backend;
+    img_t const *img;
+    img_t *out;
+    kernel_t const *kernel;
+    bench_shape_t shape;
+    size_t threads;
+    size_t reps;
+} bench_point_t;
+
+/* bench_data.c */
+img_t *bench_image(size_t w, size_t h, unsigned int seed);
+void bench_image_free(img_t *img);
+kernel_t *bench_kernel(size_t size, bench_shape_t shape);
+void bench_kernel_free(kernel_t *kernel);
+
+#endif /* BENCH_H */
@@ -0,0 +1,212 @@
+#include "bench.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_REPS 5
+#define BENCH_NSIZES 3
+#define BENCH_NKERNELS 5
+
+static char const *const bench_names[BENCH_COUNT] = {
+	"portion", "tiles", "fixed", "planar", "box"
+};
+static size_t const bench_sizes[BENCH_NSIZES][2] = {
+	{640, 480}, {1920, 1080}, {3840, 2160}
+};
+static size_t const bench_kernels[BENCH_NKERNELS][2] = {
+	{3, BENCH_GAUSSIAN}, {9, BENCH_GAUSSIAN}, {31, BENCH_GAUSSIAN},
+	{9, BENCH_ANISOTROPIC}, {31, BENCH_ANISOTROPIC}
+};
+static char const *const bench_shapes[] = {"gaussian", "anisotropic"};
+static char const *const bench_policies[] = {"float", "cores", "nodes"};
+
+/**
+ * cmp_double - qsort comparison program for doubles, in ascending order
+ * @a: a pointer to the first double
+ * @b: a pointer to the second double
+ * Return: a negative, zero or positive value as a is below, equal to or
+ *         above b
+ */
+
+static int cmp_double(void const *a, void const *b)
+{
+	double da = *(double const *)a, db = *(double const *)b;
+
+	return ((da > db) - (da < db));
+}
+
+/**
+ * bench_call - program that blurs the image of a grid point once with
+ * the backend of the point
+ * @pt: a pointer to the grid point
+ * Return: nothing (void)
+ */
+
+static void bench_call(bench_point_t const *pt)
+{
+	blur_opts_t opts = {EDGE_RENORMALIZE, 0, 0, 0, 0};
+	blur_portion_t portion;
+
+	switch (pt->backend)
+	{
+	case BENCH_PORTION:
+		portion.img = pt->img, portion.img_blur = pt->out;
+		portion.x = portion.y = 0;
+		portion.w = pt->img->w, portion.h = pt->img->h;
+		portion.kernel = pt->kernel, portion.edge = EDGE_RENORMALIZE;
+		blur_portion(&portion);
+		break;
+	case BENCH_TILES:
+		blur_image(pt->out, pt->img, pt->kernel);
+		break;
+	case BENCH_FIXED:
+	case BENCH_PLANAR:
+		opts.fixed = pt->backend == BENCH_FIXED;
+		opts.planar = pt->backend == BENCH_PLANAR;
+		blur_image_opts(pt->out, pt->img, pt->kernel, &opts);
+		break;
+	default:
+		blur_box(pt->out, pt->img, pt->kernel->size / 2,
+			 EDGE_RENORMALIZE);
+	}
+}
+
+/**
+ * bench_point - program that times one point of the benchmark grid and
+ * writes its CSV record
+ * the pool is resized to the thread count of the point, one untimed call
+ * warms the caches up, then every timed call is measured on its own so
+ * that the median and the 99th percentile (nearest rank) can be reported
+ * @csv: the stream the record is written to
+ * @pt: a pointer to the grid point
+ * @base: the median of the same point on one thread, 0 if this is it
+ * Return: the median time of a call, in milliseconds, or 0 on failure
+ */
+
+static double bench_point(FILE *csv, bench_point_t const *pt, double base)
+{
+	double *ms = malloc(sizeof(double) * pt->reps), p50, p99;
+	struct timespec t0, t1;
+	size_t i, px = pt->img->w * pt->img->h;
+
+	if (!ms)
+		return (0);
+	blur_pool_init(pt->threads);
+	bench_call(pt);
+	for (i = 0; i < pt->reps; i++)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		bench_call(pt);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		ms[i] = (t1.tv_sec - t0.tv_sec) * 1e3 +
+			(t1.tv_nsec - t0.tv_nsec) / 1e6;
+	}
+	qsort(ms, pt->reps, sizeof(double), cmp_double);
+	p50 = ms[(pt->reps + 1) / 2 - 1];
+	p99 = ms[(99 * pt->reps + 99) / 100 - 1];
+	fprintf(csv, "%s,%lu,%lu,%lu,%s,%lu,%s,%lu,%.3f,%.3f,%.2f,%.3f\n",
+		bench_names[pt->backend], (unsigned long)pt->img->w,
+		(unsigned long)pt->img->h, (unsigned long)pt->kernel->size,
+		bench_shapes[pt->shape], (unsigned long)pt->threads,
+		bench_policies[blur_pool_policy(NULL)],
+		(unsigned long)pt->reps, p50, p99,
+		px / (p50 * 1e3), base > 0 ? base / (p50 * pt->threads) : 1.0);
+	fflush(csv);
+	free(ms);
+	return (p50);
+}
+
+/**
+ * bench_grid - program that times every backend, kernel and thread count
+ * on one image
+ * the Gaussian kernels are separable; the anisotropic ones are not, the
+ * small one going through the direct 2D convolution and the large one,
+ * past the threshold of kernel_fft_size, through the FFT
+ * the thread counts are the powers of two below max_threads, then
+ * max_threads; blur_portion runs on the calling thread only, so it is
+ * timed on one thread
+ * @csv: the stream the records are written to
+ * @pt: a pointer to a grid point whose img, out and reps are set
+ * @max_threads: the largest number of blur workers
+ * Return: 1 on success, 0 if a kernel could not be generated
+ */
+
+static int bench_grid(FILE *csv, bench_point_t *pt, size_t max_threads)
+{
+	kernel_t *kernel;
+	double base, p50;
+	size_t k, b;
+
+	for (k = 0; k < BENCH_NKERNELS; k++)
+	{
+		pt->shape = (bench_shape_t)bench_kernels[k][1];
+		kernel = bench_kernel(bench_kernels[k][0], pt->shape);
+		if (!kernel)
+			return (0);
+		pt->kernel = kernel;
+		for (b = 0; b < BENCH_COUNT; b++)
+		{
+			pt->backend = (bench_backend_t)b;
+			for (base = 0, pt->threads = 1; ; pt->threads *= 2)
+			{
+				if (pt->threads > max_threads)
+					pt->threads = max_threads;
+				p50 = bench_point(csv, pt, base);
+				base = base ? base : p50;
+				if (pt->threads == max_threads ||
+				    b == BENCH_PORTION)
+					break;
+			}
+		}
+		bench_kernel_free(kernel);
+	}
+	return (1);
+}
+
+/**
+ * main - entry point of the blur benchmark
+ * every backend is timed over a grid of image sizes, kernel sizes and
+ * shapes, and thread counts; one CSV record is written per point with the
+ * median and 99th percentile time per call, the throughput in megapixels
+ * per second and the scaling efficiency against one thread; the placement
+ * of the workers (see BLUR_AFFINITY) is recorded in every record
+ * usage: bench_blur [csv_path [repetitions [max_threads]]]
+ * @argc: the number of arguments
+ * @argv: the arguments
+ * Return: EXIT_SUCCESS, or EXIT_FAILURE on failure
+ */
+
+int main(int argc, char **argv)
+{
+	FILE *csv = argc > 1 ? fopen(argv[1], "w") : stdout;
+	long online = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t max = online > 0 ? (size_t)online : 1, s;
+	bench_point_t pt;
+	img_t *img, *out;
+	int ok = 1;
+
+	pt.reps = argc > 2 ? strtoul(argv[2], NULL, 10) : BENCH_REPS;
+	pt.reps = pt.reps ? pt.reps : 1;
+	max = argc > 3 && atoi(argv[3]) > 0 ? (size_t)atoi(argv[3]) : max;
+	if (!csv)
+	{
+		fprintf(stderr, "bench_blur: cannot open %s\n", argv[1]);
+		return (EXIT_FAILURE);
+	}
+	fprintf(csv, "backend,width,height,kernel,shape,threads,policy,reps,"
+		"p50_ms,p99_ms,mpix_s,efficiency\n");
+	for (s = 0; ok && s < BENCH_NSIZES; s++)
+	{
+		img = bench_image(bench_sizes[s][0], bench_sizes[s][1], s + 1);
+		out = bench_image(bench_sizes[s][0], bench_sizes[s][1], 0);
+		pt.img = img, pt.out = out;
+		ok = img && out && bench_grid(csv, &pt, max);
+		bench_image_free(img);
+		bench_image_free(out);
+	}
+	if (csv != stdout)
+		fclose(csv);
+	if (!ok)
+		fprintf(stderr, "bench_blur: out of memory\n");
+	return (ok ? EXIT_SUCCESS : EXIT_FAILURE);
+}
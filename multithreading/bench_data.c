@@ -0,0 +1,129 @@
+#include "bench.h"
+
+#include <math.h>
+
+/**
+ * bench_image - program that generates a synthetic image for the
+ * benchmark
+ * the pixels follow smooth gradients overlaid with pseudo-random noise, so
+ * that the blur works on realistic values without favoring any backend
+ * @w: the width of the image
+ * @h: the height of the image
+ * @seed: the seed of the noise
+ * Return: a pointer to the image, to be released with bench_image_free,
+ *         or NULL on failure
+ */
+
+img_t *bench_image(size_t w, size_t h, unsigned int seed)
+{
+	img_t *img = malloc(sizeof(*img));
+	size_t x, y;
+	pixel_t *p;
+
+	if (!img)
+		return (NULL);
+	img->w = w, img->h = h;
+	img->pixels = malloc(sizeof(pixel_t) * w * h);
+	if (!img->pixels)
+	{
+		free(img);
+		return (NULL);
+	}
+	for (y = 0, p = img->pixels; y < h; y++)
+		for (x = 0; x < w; x++, p++)
+		{
+			seed = seed * 1103515245 + 12345;
+			p->r = (x * 255 / w + (seed >> 16 & 63)) & 0xff;
+			p->g = (y * 255 / h + (seed >> 22 & 63)) & 0xff;
+			p->b = ((x + y) * 127 / (w + h) + (seed >> 8 & 63));
+		}
+	return (img);
+}
+
+/**
+ * bench_image_free - program that releases a synthetic image
+ * @img: a pointer to the image, may be NULL
+ * Return: nothing (void)
+ */
+
+void bench_image_free(img_t *img)
+{
+	if (!img)
+		return;
+	free(img->pixels);
+	free(img);
+}
+
+/**
+ * bench_weight - program that computes one weight of a synthetic kernel
+ * the anisotropic kernel is three times narrower across its main axis,
+ * which is rotated by 30 degrees, so it is not the product of a row and a
+ * column
+ * @dx: the horizontal offset of the weight from the center of the kernel
+ * @dy: the vertical offset of the weight from the center of the kernel
+ * @sigma: the standard deviation along the main axis
+ * @shape: the shape of the kernel
+ * Return: the weight
+ */
+
+static float bench_weight(float dx, float dy, float sigma, bench_shape_t shape)
+{
+	float u = dx, v = dy;
+
+	if (shape == BENCH_ANISOTROPIC)
+	{
+		u = 0.8660254f * dx + 0.5f * dy;
+		v = 3 * (0.8660254f * dy - 0.5f * dx);
+	}
+	return (expf(-(u * u + v * v) / (2 * sigma * sigma)));
+}
+
+/**
+ * bench_kernel - program that generates a convolution kernel for the
+ * benchmark, its standard deviation along its main axis being a third of
+ * its radius
+ * @size: the size of the kernel, odd
+ * @shape: the shape of the kernel
+ * Return: a pointer to the kernel, to be released with bench_kernel_free,
+ *         or NULL on failure
+ */
+
+kernel_t *bench_kernel(size_t size, bench_shape_t shape)
+{
+	kernel_t *kernel = malloc(sizeof(*kernel));
+	float sigma = size > 1 ? (size - 1) / 6.0f : 1, c = (size - 1) / 2.0f;
+	size_t i, j;
+
+	if (!kernel)
+		return (NULL);
+	kernel->size = size;
+	kernel->matrix = malloc(sizeof(float *) * size +
+				sizeof(float) * size * size);
+	if (!kernel->matrix)
+	{
+		free(kernel);
+		return (NULL);
+	}
+	for (i = 0; i < size; i++)
+	{
+		kernel->matrix[i] = (float *)(kernel->matrix + size) + i * size;
+		for (j = 0; j < size; j++)
+			kernel->matrix[i][j] = bench_weight(j - c, i - c, sigma,
+							    shape);
+	}
+	return (kernel);
+}
+
+/**
+ * bench_kernel_free - program that releases a synthetic kernel
+ * @kernel: a pointer to the kernel, may be NULL
+ * Return: nothing (void)
+ */
+
+void bench_kernel_free(kernel_t *kernel)
+{
+	if (!kernel)
+		return;
+	free(kernel->matrix);
+	free(kernel);
+}
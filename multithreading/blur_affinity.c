@@ -0,0 +1,181 @@
+#define _GNU_SOURCE
+#include "multithreading.h"
+
+#include <sched.h>
+#include <string.h>
+
+#define AFFINITY_MAX_CPUS 1024
+
+/**
+ * struct affinity_s - Placement of the blur workers
+ * @policy: the placement policy
+ * @nnodes: number of NUMA nodes with a processor the process may run on
+ * @first:  index in @cpus of the first processor of every node, followed
+ *          by the total number of processors
+ * @cpus:   processors the process may run on, grouped by node
+ */
+
+static struct affinity_s
+{
+	pool_policy_t policy;
+	size_t nnodes;
+	size_t first[POOL_MAX_NODES + 1];
+	int cpus[AFFINITY_MAX_CPUS];
+} aff;
+
+/**
+ * affinity_parse - program that reads the processors of a NUMA node
+ * the list has the format of the kernel cpulist files, such as 0-3,8,10-11;
+ * the processors the process may not run on are left out
+ * @f: the cpulist file of the node
+ * @set: the processors the process may run on
+ * @n: the number of processors already listed in aff.cpus
+ * Return: the number of processors listed in aff.cpus after the node's
+ */
+
+static size_t affinity_parse(FILE *f, cpu_set_t const *set, size_t n)
+{
+	int a, b, c;
+
+	while (fscanf(f, "%d", &a) == 1)
+	{
+		b = a, c = fgetc(f);
+		if (c == '-' && fscanf(f, "%d", &b) == 1)
+			c = fgetc(f);
+		for (; a <= b && n < AFFINITY_MAX_CPUS; a++)
+			if (a < CPU_SETSIZE && CPU_ISSET(a, set))
+				aff.cpus[n++] = a;
+		if (c != ',')
+			break;
+	}
+	return (n);
+}
+
+/**
+ * affinity_init - program that reads the NUMA topology of the processors
+ * the process may run on, and the placement policy
+ * this function is marked with the constructor attribute, so the topology
+ * is read once at startup from /sys/devices/system/node; without it every
+ * processor is put on a single node; the BLUR_AFFINITY environment
+ * variable (float, cores or nodes) selects the policy, float by default
+ * Return: nothing (void)
+ */
+
+__attribute__((constructor))
+static void affinity_init(void)
+{
+	char const *env = getenv("BLUR_AFFINITY");
+	char path[64];
+	cpu_set_t set;
+	size_t n = 0;
+	FILE *f;
+	int i;
+
+	if (sched_getaffinity(0, sizeof(set), &set))
+		return;
+	for (i = 0; i < POOL_MAX_NODES; i++)
+	{
+		sprintf(path, "/sys/devices/system/node/node%d/cpulist", i);
+		f = fopen(path, "r");
+		if (!f)
+			continue;
+		aff.first[aff.nnodes] = n;
+		n = affinity_parse(f, &set, n);
+		aff.nnodes += n > aff.first[aff.nnodes];
+		fclose(f);
+	}
+	if (!aff.nnodes)
+		for (i = 0, aff.nnodes = 1; i < CPU_SETSIZE; i++)
+			if (CPU_ISSET(i, &set) && n < AFFINITY_MAX_CPUS)
+				aff.cpus[n++] = i;
+	aff.first[aff.nnodes] = n;
+	if (env && !strcmp(env, "cores"))
+		aff.policy = POOL_CORES;
+	else if (env && !strcmp(env, "nodes"))
+		aff.policy = POOL_NODES;
+}
+
+/**
+ * blur_pool_policy - program that selects the placement policy of the
+ * blur workers, which applies to the workers started by the next
+ * blur_pool_init
+ * @policy: a pointer to the policy to select, NULL to keep the current one
+ * Return: the policy in effect
+ */
+
+pool_policy_t blur_pool_policy(pool_policy_t const *policy)
+{
+	if (policy)
+		aff.policy = *policy;
+	return (aff.policy);
+}
+
+/**
+ * blur_pool_cpu - program that tells where a blur worker runs
+ * with POOL_CORES worker i goes to the i-th processor, with POOL_NODES
+ * worker i goes to node i modulo the number of nodes, on the processors
+ * of that node in turn; worker 0, the caller of blur_pool_run, is never
+ * pinned and is reported where it currently runs
+ * @worker: the index of the worker
+ * @node: receives the index of the node of the processor, may be NULL
+ * Return: the processor of the worker, or -1 if it is not pinned
+ */
+
+int blur_pool_cpu(size_t worker, size_t *node)
+{
+	size_t total = aff.first[aff.nnodes], k = 0, i;
+	int cpu = -1;
+
+	if (!total || (aff.policy == POOL_FLOAT && worker))
+		cpu = -1;
+	else if (!worker)
+		cpu = sched_getcpu();
+	else if (aff.policy == POOL_CORES)
+		cpu = aff.cpus[worker % total];
+	else
+	{
+		k = worker % aff.nnodes;
+		i = worker / aff.nnodes % (aff.first[k + 1] - aff.first[k]);
+		cpu = aff.cpus[aff.first[k] + i];
+	}
+	for (i = 0; cpu >= 0 && i < total && aff.cpus[i] != cpu; i++)
+		;
+	for (k = 0; cpu >= 0 && k + 1 < aff.nnodes && aff.first[k + 1] <= i;)
+		k++;
+	if (node)
+		*node = k;
+	return (cpu);
+}
+
+/**
+ * blur_pool_pin - program that pins the calling blur worker according to
+ * the placement policy and finds its home range of the pool jobs
+ * @worker: the index of the calling worker, 0 for the caller of
+ *          blur_pool_run, which is never pinned
+ * @nranges: receives the number of ranges the pool jobs are split into,
+ *           the number of nodes with POOL_NODES and 1 otherwise; may be
+ *           NULL
+ * Return: the range the worker claims items from first
+ */
+
+size_t blur_pool_pin(size_t worker, size_t *nranges)
+{
+	size_t node = 0;
+	cpu_set_t set;
+	int cpu;
+
+	if (nranges)
+		*nranges = aff.policy == POOL_NODES ? aff.nnodes : 1;
+	if (aff.policy == POOL_FLOAT)
+		return (0);
+	cpu = blur_pool_cpu(worker, &node);
+	if (worker && cpu >= 0)
+	{
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set))
+			fprintf(stderr, "blur_pool_pin: cannot pin to cpu %d\n",
+				cpu);
+	}
+	return (aff.policy == POOL_NODES ? node : 0);
+}
@@ -0,0 +1,204 @@
+#include "multithreading.h"
+
+#define BATCH_DEPTH 4
+
+/**
+ * struct batch_s - State of a pipelined blur of a batch of frames
+ * @b:        the batch description
+ * @ck:       the kernel, compiled once for every frame
+ * @in_free:  source frames ready to be loaded
+ * @ready:    loaded source frames waiting to be blurred
+ * @out_free: destination frames ready to be blurred into
+ * @done:     blurred frames waiting to be stored
+ * @failed:   set once a frame fails to load, blur or store
+ */
+
+typedef struct batch_s
+{
+	blur_batch_t const *b;
+	ckernel_t *ck;
+	frame_queue_t in_free;
+	frame_queue_t ready;
+	frame_queue_t out_free;
+	frame_queue_t done;
+	int failed;
+} batch_t;
+
+/**
+ * batch_load - thread entry program of the load stage of a batch
+ * frames are taken from the source pool, filled by the load callback and
+ * handed to the blur stage; the stage stops after the last frame or the
+ * first failure and then ends the stream
+ * @arg: a pointer to the batch_t
+ * Return: NULL
+ */
+
+static void *batch_load(void *arg)
+{
+	batch_t *s = arg;
+	frame_t *f;
+	size_t i;
+
+	for (i = 0; i < s->b->count; i++)
+	{
+		f = frame_queue_pop(&s->in_free);
+		f->index = i;
+		if (__atomic_load_n(&s->failed, __ATOMIC_RELAXED) ||
+		    !s->b->load(s->b->ctx, i, &f->img))
+		{
+			__atomic_store_n(&s->failed, 1, __ATOMIC_RELAXED);
+			frame_queue_push(&s->in_free, f);
+			break;
+		}
+		frame_queue_push(&s->ready, f);
+	}
+	frame_queue_push(&s->ready, NULL);
+	return (NULL);
+}
+
+/**
+ * batch_store - thread entry program of the store stage of a batch
+ * blurred frames are handed to the store callback in order, then returned
+ * to the destination pool; after a failure the remaining frames are only
+ * drained
+ * @arg: a pointer to the batch_t
+ * Return: NULL
+ */
+
+static void *batch_store(void *arg)
+{
+	batch_t *s = arg;
+	frame_t *f;
+
+	while ((f = frame_queue_pop(&s->done)))
+	{
+		if (!__atomic_load_n(&s->failed, __ATOMIC_RELAXED) &&
+		    !s->b->store(s->b->ctx, f->index, &f->img))
+			__atomic_store_n(&s->failed, 1, __ATOMIC_RELAXED);
+		frame_queue_push(&s->out_free, f);
+	}
+	return (NULL);
+}
+
+/**
+ * batch_setup - program that allocates the frame pools and the queues of a
+ * batch; every pixel buffer comes from a single block, allocated once for
+ * the whole batch
+ * @s: a pointer to the batch state
+ * @depth: the number of frames in each pool
+ * Return: the block of frames and pixels to be released with free, or NULL
+ *         on failure
+ */
+
+static frame_t *batch_setup(batch_t *s, size_t depth)
+{
+	frame_queue_t *queues[4];
+	size_t px = s->b->w * s->b->h, i, n;
+	frame_t *frames;
+	pixel_t *pixels;
+
+	frames = malloc(sizeof(frame_t) * 2 * depth +
+			sizeof(pixel_t) * px * 2 * depth);
+	if (!frames)
+		return (NULL);
+	queues[0] = &s->in_free, queues[1] = &s->ready;
+	queues[2] = &s->out_free, queues[3] = &s->done;
+	for (n = 0; n < 4 && frame_queue_init(queues[n], depth + 1); n++)
+		;
+	if (n < 4)
+	{
+		while (n--)
+			frame_queue_destroy(queues[n]);
+		free(frames);
+		return (NULL);
+	}
+	pixels = (pixel_t *)(frames + 2 * depth);
+	for (i = 0; i < 2 * depth; i++)
+	{
+		frames[i].img.w = s->b->w, frames[i].img.h = s->b->h;
+		frames[i].img.pixels = pixels + i * px;
+		frame_queue_push(i < depth ? &s->in_free : &s->out_free,
+				 frames + i);
+	}
+	return (frames);
+}
+
+/**
+ * batch_blur - program that runs the blur stage of a batch on the calling
+ * thread, until the load stage ends the stream
+ * once the batch failed the loaded frames are only returned to the source
+ * pool, so the load stage is never left without a frame to stop on
+ * @s: a pointer to the batch state
+ * Return: nothing (void)
+ */
+
+static void batch_blur(batch_t *s)
+{
+	frame_t *src, *dst;
+
+	while ((src = frame_queue_pop(&s->ready)))
+	{
+		if (__atomic_load_n(&s->failed, __ATOMIC_RELAXED))
+		{
+			frame_queue_push(&s->in_free, src);
+			continue;
+		}
+		dst = frame_queue_pop(&s->out_free);
+		if (!blur_image_ck(&dst->img, &src->img, s->ck, s->b->opts))
+			__atomic_store_n(&s->failed, 1, __ATOMIC_RELAXED);
+		dst->index = src->index;
+		frame_queue_push(&s->in_free, src);
+		frame_queue_push(&s->done, dst);
+	}
+}
+
+/**
+ * blur_batch - program that blurs a batch of frames of the same size,
+ * pipelining their loading, blurring and storing
+ * a load thread and a store thread run the callbacks of the batch while
+ * the calling thread blurs on the blur pool, so the I/O of a frame
+ * overlaps the blur of its neighbours; the queues between the stages are
+ * bounded by the depth of the batch and every frame comes from one of two
+ * pools allocated up front, so no pixels are allocated per frame
+ * @batch: a pointer to the batch description
+ * Return: 1 if every frame was loaded, blurred and stored, 0 otherwise
+ */
+
+int blur_batch(blur_batch_t const *batch)
+{
+	size_t depth = batch->depth ? batch->depth : BATCH_DEPTH;
+	pthread_t loader, storer;
+	frame_t *frames;
+	batch_t s;
+	int loading, storing;
+
+	s.b = batch, s.failed = 0;
+	s.ck = kernel_compile(batch->kernel);
+	frames = s.ck ? batch_setup(&s, depth) : NULL;
+	if (!frames)
+	{
+		kernel_free(s.ck);
+		fprintf(stderr, "blur_batch: out of memory\n");
+		return (0);
+	}
+	loading = !pthread_create(&loader, NULL, batch_load, &s);
+	storing = !pthread_create(&storer, NULL, batch_store, &s);
+	if (!loading || !storing)
+	{
+		fprintf(stderr, "blur_batch: cannot start the stage threads\n");
+		__atomic_store_n(&s.failed, 1, __ATOMIC_RELAXED);
+	}
+	if (!loading)
+		frame_queue_push(&s.ready, NULL);
+	batch_blur(&s);
+	frame_queue_push(&s.done, NULL);
+	if (loading)
+		pthread_join(loader, NULL);
+	if (storing)
+		pthread_join(storer, NULL);
+	frame_queue_destroy(&s.in_free), frame_queue_destroy(&s.ready);
+	frame_queue_destroy(&s.out_free), frame_queue_destroy(&s.done);
+	free(frames);
+	kernel_free(s.ck);
+	return (!s.failed);
+}
@@ -0,0 +1,169 @@
+#include "multithreading.h"
+
+#include <math.h>
+
+#define BILATERAL_DIST(p, q) ((size_t)abs((p)->r - (q)->r) + \
+	(size_t)abs((p)->g - (q)->g) + (size_t)abs((p)->b - (q)->b))
+
+/**
+ * bilateral_checked - program that filters one pixel close to the borders
+ * of the image
+ * every tap is checked against the image bounds; with EDGE_RENORMALIZE
+ * the taps falling outside of the image are left out, the other modes
+ * read them through edge_index
+ * @b: a pointer to the weights of the filter
+ * @tile: a pointer to the tile of the pixel
+ * @x: the column of the pixel
+ * @y: the row of the pixel
+ * Return: nothing (void)
+ */
+
+static void bilateral_checked(bilateral_t const *b, blur_portion_t const *tile,
+			      size_t x, size_t y)
+{
+	img_t const *img = tile->img;
+	pixel_t const *c = img->pixels + y * img->w + x, *q;
+	pixel_t *out = tile->img_blur->pixels + y * tile->img_blur->w + x;
+	long r = (long)b->radius, dx, dy, px, py;
+	float acc[3] = {0, 0, 0}, sum = 0, wt;
+	float const *space = b->space;
+
+	for (dy = -r; dy <= r; dy++)
+		for (dx = -r; dx <= r; dx++, space++)
+		{
+			px = (long)x + dx, py = (long)y + dy;
+			if (tile->edge == EDGE_RENORMALIZE &&
+			    (px < 0 || px >= (long)img->w || py < 0 ||
+			     py >= (long)img->h))
+				continue;
+			q = img->pixels + edge_index(py, img->h, tile->edge) *
+				img->w + edge_index(px, img->w, tile->edge);
+			wt = *space * b->range[BILATERAL_DIST(c, q)];
+			acc[0] += q->r * wt, acc[1] += q->g * wt;
+			acc[2] += q->b * wt, sum += wt;
+		}
+	out->r = acc[0] / sum, out->g = acc[1] / sum, out->b = acc[2] / sum;
+}
+
+/**
+ * bilateral_run - program that filters a run of pixels of a row whose
+ * taps all fall inside the image
+ * the taps are read through the precomputed offsets, without any check
+ * @b: a pointer to the weights of the filter
+ * @tile: a pointer to the tile of the pixels
+ * @y: the row of the pixels
+ * @from: the first column to filter
+ * @to: the column past the last column to filter
+ * Return: nothing (void)
+ */
+
+static void bilateral_run(bilateral_t const *b, blur_portion_t const *tile,
+			  size_t y, size_t from, size_t to)
+{
+	size_t n = (2 * b->radius + 1) * (2 * b->radius + 1), x, i;
+	pixel_t const *c = tile->img->pixels + y * tile->img->w + from, *q;
+	pixel_t *out = tile->img_blur->pixels + y * tile->img_blur->w + from;
+	float acc[3], sum, wt;
+
+	for (x = from; x < to; x++, c++, out++)
+	{
+		acc[0] = acc[1] = acc[2] = sum = 0;
+		for (i = 0; i < n; i++)
+		{
+			q = c + b->offs[i];
+			wt = b->space[i] * b->range[BILATERAL_DIST(c, q)];
+			acc[0] += q->r * wt, acc[1] += q->g * wt;
+			acc[2] += q->b * wt, sum += wt;
+		}
+		out->r = acc[0] / sum, out->g = acc[1] / sum;
+		out->b = acc[2] / sum;
+	}
+}
+
+/**
+ * bilateral_tile - stencil program that runs a bilateral filter over one
+ * tile of an image
+ * @tile: a pointer to the tile
+ * @ctx: a pointer to the bilateral_t weights of the filter
+ * Return: always 1
+ */
+
+static int bilateral_tile(blur_portion_t const *tile, void const *ctx)
+{
+	bilateral_t const *b = ctx;
+	size_t r = b->radius, w = tile->img->w, x, y, xa, xb;
+	size_t end = tile->x + tile->w;
+
+	xa = tile->x > r ? tile->x : r;
+	xb = w > r ? w - r : 0;
+	xb = xb < end ? xb : end;
+	xa = xa < xb ? xa : (xb = end);
+	for (y = tile->y; y < tile->y + tile->h; y++)
+	{
+		if (y < r || y + r >= tile->img->h)
+		{
+			for (x = tile->x; x < end; x++)
+				bilateral_checked(b, tile, x, y);
+			continue;
+		}
+		for (x = tile->x; x < xa; x++)
+			bilateral_checked(b, tile, x, y);
+		bilateral_run(b, tile, y, xa, xb);
+		for (x = xb; x < end; x++)
+			bilateral_checked(b, tile, x, y);
+	}
+	return (1);
+}
+
+/**
+ * blur_bilateral - program that runs a bilateral filter over an entire
+ * image using multithreading
+ * every tap of the square footprint of 2 * radius + 1 pixels is weighted
+ * by a Gaussian of its distance to the output pixel (sigma_s, in pixels)
+ * times a Gaussian of its color distance (sigma_r), the sum of the
+ * absolute differences of the three channels; both are tabulated once per
+ * call, so a tap costs two table reads; edges are smoothed while they are
+ * kept sharp; the taps out of the image follow opts->edge
+ * @img_blur: a pointer to the output image data structure
+ * @img: a pointer to the input image data structure
+ * @radius: the radius of the footprint
+ * @sigma_s: the spatial standard deviation, in pixels
+ * @sigma_r: the range standard deviation, in color distance units
+ * @opts: a pointer to the blur options, NULL for the defaults; planar and
+ *        fixed are ignored
+ * Return: 1 on success, 0 on failure
+ */
+
+int blur_bilateral(img_t *img_blur, img_t const *img, size_t radius,
+		   float sigma_s, float sigma_r, blur_opts_t const *opts)
+{
+	size_t size = 2 * radius + 1, i;
+	long r = (long)radius, dx, dy;
+	bilateral_t b;
+	stencil_t st;
+	int ok;
+
+	b.radius = radius;
+	b.offs = malloc((sizeof(long) + sizeof(float)) * size * size);
+	if (!b.offs || sigma_s <= 0 || sigma_r <= 0)
+	{
+		fprintf(stderr, "blur_bilateral: cannot build the weights\n");
+		free(b.offs);
+		return (0);
+	}
+	b.space = (float *)(b.offs + size * size);
+	for (i = 0; i < size * size; i++)
+	{
+		dx = (long)(i % size) - r, dy = (long)(i / size) - r;
+		b.space[i] = expf(-(dx * dx + dy * dy) /
+				  (2 * sigma_s * sigma_s));
+		b.offs[i] = dy * (long)img->w + dx;
+	}
+	for (i = 0; i < sizeof(b.range) / sizeof(*b.range); i++)
+		b.range[i] = expf(-(float)(i * i) / (2 * sigma_r * sigma_r));
+	st.size = size, st.kernel = NULL;
+	st.portion = bilateral_tile, st.ctx = &b;
+	ok = blur_stencil(img_blur, img, &st, opts);
+	free(b.offs);
+	return (ok);
+}
@@ -0,0 +1,250 @@
+#include "multithreading.h"
+
+#include <math.h>
+
+#define BOX_SHIFT 40
+#define BOX_ROUND ((uint64_t)1 << (BOX_SHIFT - 1))
+#define BOX_BAND 16
+#define BOX_STRIP 64
+#define BOX_DIV(sum, inv) ((uint8_t)(((sum) * (inv) + BOX_ROUND) >> BOX_SHIFT))
+
+/**
+ * struct box_axis_s - Sliding window of a box blur along one axis
+ * @map: source index of every window position, -1 for an out-of-bounds
+ *       position contributing nothing; n + 2 * radius entries, the window
+ *       of output i spanning map[i] to map[i + 2 * radius]
+ * @inv: per output fixed-point reciprocal of the number of contributing
+ *       positions, scaled by 1 << BOX_SHIFT
+ */
+
+typedef struct box_axis_s
+{
+	long *map;
+	uint64_t *inv;
+} box_axis_t;
+
+/**
+ * struct box_job_s - Argument of the pool jobs of a box blur pass
+ * @src:  the source image
+ * @dst:  the destination image
+ * @tmp:  the image holding the horizontal pass
+ * @r:    the radius of the box
+ * @axis: the horizontal and vertical sliding windows
+ * @zero: a row of black pixels, read for out-of-bounds rows
+ */
+
+typedef struct box_job_s
+{
+	img_t const *src;
+	img_t *dst;
+	img_t *tmp;
+	size_t r;
+	box_axis_t axis[2];
+	pixel_t *zero;
+} box_job_t;
+
+/**
+ * box_axis - program that lays out the sliding window of a box blur along
+ * one axis of an image
+ * with EDGE_RENORMALIZE the out-of-bounds positions are dropped and the
+ * sum divided by the number of in-bounds positions, the other edge modes
+ * map every position back inside the image and divide by 2 * r + 1
+ * @a: receives the window, a->map to be released with free
+ * @n: the size of the image along the axis
+ * @r: the radius of the box
+ * @mode: the edge mode
+ * Return: 1 on success, 0 on failure
+ */
+
+static int box_axis(box_axis_t *a, size_t n, size_t r, edge_mode_t mode)
+{
+	size_t i, lo, hi;
+	long p;
+
+	a->map = malloc(sizeof(long) * (n + 2 * r) + sizeof(uint64_t) * n);
+	if (!a->map)
+		return (0);
+	a->inv = (uint64_t *)(a->map + n + 2 * r);
+	for (i = 0; i < n + 2 * r; i++)
+	{
+		p = (long)i - (long)r;
+		if (mode != EDGE_RENORMALIZE)
+			a->map[i] = edge_index(p, n, mode);
+		else
+			a->map[i] = p < 0 || p >= (long)n ? -1 : p;
+	}
+	for (i = 0; i < n; i++)
+	{
+		lo = i > r ? i - r : 0;
+		hi = i + r < n ? i + r + 1 : n;
+		hi = mode != EDGE_RENORMALIZE ? 2 * r + 1 : hi - lo;
+		a->inv[i] = (((uint64_t)1 << BOX_SHIFT) + hi - 1) / hi;
+	}
+	return (1);
+}
+
+/**
+ * box_h_job - pool job program that runs the horizontal pass of a box blur
+ * over a band of rows
+ * the window sum is updated with the pixel entering and the pixel leaving
+ * the window, so the cost per pixel does not depend on the radius
+ * @arg: a pointer to the box_job_t describing the pass
+ * @band: the index of the band of BOX_BAND rows
+ * Return: nothing (void)
+ */
+
+static void box_h_job(void *arg, size_t band)
+{
+	box_job_t const *job = arg;
+	box_axis_t const *a = job->axis;
+	size_t x, y, w = job->src->w, end = (band + 1) * BOX_BAND;
+	pixel_t const *in, *add, *sub;
+	pixel_t *out;
+	uint64_t s[3];
+
+	for (y = band * BOX_BAND; y < end && y < job->src->h; y++)
+	{
+		in = job->src->pixels + y * w;
+		out = job->tmp->pixels + y * w;
+		s[0] = s[1] = s[2] = 0;
+		for (x = 0; x < 2 * job->r; x++)
+		{
+			add = a->map[x] < 0 ? job->zero : in + a->map[x];
+			s[0] += add->r, s[1] += add->g, s[2] += add->b;
+		}
+		for (x = 0; x < w; x++)
+		{
+			add = a->map[x + 2 * job->r] < 0 ? job->zero :
+				in + a->map[x + 2 * job->r];
+			sub = a->map[x] < 0 ? job->zero : in + a->map[x];
+			s[0] += add->r, s[1] += add->g, s[2] += add->b;
+			out[x].r = BOX_DIV(s[0], a->inv[x]);
+			out[x].g = BOX_DIV(s[1], a->inv[x]);
+			out[x].b = BOX_DIV(s[2], a->inv[x]);
+			s[0] -= sub->r, s[1] -= sub->g, s[2] -= sub->b;
+		}
+	}
+}
+
+/**
+ * box_v_job - pool job program that runs the vertical pass of a box blur
+ * over a strip of columns
+ * one running sum per byte of the strip is updated with the row entering
+ * and the row leaving the window, so the inner loops walk contiguous
+ * memory and the cost per pixel does not depend on the radius
+ * @arg: a pointer to the box_job_t describing the pass
+ * @strip: the index of the strip of BOX_STRIP columns
+ * Return: nothing (void)
+ */
+
+static void box_v_job(void *arg, size_t strip)
+{
+	box_job_t const *job = arg;
+	box_axis_t const *a = job->axis + 1;
+	size_t i, y, w = job->tmp->w, x0 = strip * BOX_STRIP, n;
+	uint8_t const *add, *sub, *base = (uint8_t const *)job->tmp->pixels;
+	uint8_t *out;
+	uint32_t s[3 * BOX_STRIP];
+
+	n = 3 * (w - x0 < BOX_STRIP ? w - x0 : BOX_STRIP);
+	for (i = 0; i < n; i++)
+		s[i] = 0;
+	for (y = 0; y < 2 * job->r; y++)
+	{
+		add = a->map[y] < 0 ? (uint8_t const *)job->zero :
+			base + 3 * (a->map[y] * w + x0);
+		for (i = 0; i < n; i++)
+			s[i] += add[i];
+	}
+	for (y = 0; y < job->tmp->h; y++)
+	{
+		add = a->map[y + 2 * job->r] < 0 ? (uint8_t const *)job->zero :
+			base + 3 * (a->map[y + 2 * job->r] * w + x0);
+		sub = a->map[y] < 0 ? (uint8_t const *)job->zero :
+			base + 3 * (a->map[y] * w + x0);
+		out = (uint8_t *)(job->dst->pixels + y * w + x0);
+		for (i = 0; i < n; i++)
+		{
+			s[i] += add[i];
+			out[i] = BOX_DIV((uint64_t)s[i], a->inv[y]);
+			s[i] -= sub[i];
+		}
+	}
+}
+
+/**
+ * blur_box - program that blurs an entire image with a box of a given
+ * radius, in a time that does not depend on the radius
+ * a horizontal pass over bands of rows is followed by a vertical pass
+ * over strips of columns, both on the blur pool; every output is the
+ * rounded mean of the (2 * radius + 1)^2 pixels around it
+ * @img_blur: a pointer to the output image data structure, which may be
+ *            the input image
+ * @img: a pointer to the input image data structure
+ * @radius: the radius of the box
+ * @mode: the edge mode
+ * Return: 1 on success, 0 on failure
+ */
+
+int blur_box(img_t *img_blur, img_t const *img, size_t radius,
+	     edge_mode_t mode)
+{
+	box_job_t job;
+	img_t tmp;
+	int ok;
+
+	if (!img_blur || !img || !img->pixels || !img_blur->pixels ||
+	    img_blur->w != img->w || img_blur->h != img->h)
+		return (0);
+	if (!img->w || !img->h)
+		return (1);
+	job.src = img, job.dst = img_blur, job.tmp = &tmp, job.r = radius;
+	tmp.w = img->w, tmp.h = img->h;
+	tmp.pixels = calloc(img->w * (img->h + 1), sizeof(pixel_t));
+	job.zero = tmp.pixels ? tmp.pixels + img->w * img->h : NULL;
+	job.axis[0].map = job.axis[1].map = NULL;
+	ok = job.zero && box_axis(job.axis, img->w, radius, mode) &&
+	     box_axis(job.axis + 1, img->h, radius, mode);
+	if (ok)
+	{
+		blur_pool_run((img->h + BOX_BAND - 1) / BOX_BAND, box_h_job,
+			      &job);
+		blur_pool_run((img->w + BOX_STRIP - 1) / BOX_STRIP, box_v_job,
+			      &job);
+	}
+	free(job.axis[0].map);
+	free(job.axis[1].map);
+	free(tmp.pixels);
+	return (ok);
+}
+
+/**
+ * blur_box_gauss - program that approximates a Gaussian blur of a given
+ * standard deviation with three successive box blurs
+ * the widths of the boxes are the two odd integers around the ideal width
+ * sqrt(12 * sigma^2 / 3 + 1), mixed so that the variance of the three
+ * passes adds up to sigma^2 as closely as possible
+ * @img_blur: a pointer to the output image data structure, which may be
+ *            the input image
+ * @img: a pointer to the input image data structure
+ * @sigma: the standard deviation of the Gaussian, in pixels
+ * @mode: the edge mode
+ * Return: 1 on success, 0 on failure
+ */
+
+int blur_box_gauss(img_t *img_blur, img_t const *img, float sigma,
+		   edge_mode_t mode)
+{
+	double ideal = sqrt(12.0 * sigma * sigma / 3 + 1), m;
+	long wl = (long)floor(ideal), i;
+
+	wl -= wl % 2 == 0;
+	wl = wl < 1 ? 1 : wl;
+	m = (12.0 * sigma * sigma - 3 * wl * wl - 12 * wl - 9) / (-4 * wl - 4);
+	for (i = 0; i < 3; i++)
+		if (!blur_box(img_blur, i ? img_blur : img,
+			      (size_t)((i < floor(m + 0.5) ? wl : wl + 2) / 2),
+			      mode))
+			return (0);
+	return (1);
+}
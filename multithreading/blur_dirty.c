@@ -0,0 +1,223 @@
+#include "multithreading.h"
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+/**
+ * struct dirty_job_s - Argument of the pool job re-blurring dirty tiles
+ * @tiles: the tiles covering the affected output pixels
+ * @ck:    the compiled kernel
+ * @fixed: whether to convolve in fixed point
+ */
+
+typedef struct dirty_job_s
+{
+	blur_portion_t *tiles;
+	ckernel_t *ck;
+	int fixed;
+} dirty_job_t;
+
+/**
+ * dirty_expand - program that finds the output pixels affected by a
+ * changed rectangle of the source image
+ * the rectangle is grown by the kernel reach, size - 1 - size / 2 pixels
+ * to the left and top and size / 2 to the right and bottom, then clipped
+ * to the image; with EDGE_WRAP the parts falling off one side wrap around
+ * to the other, which can split it into up to four rectangles
+ * @dirty: a pointer to the changed rectangle of the source image
+ * @img: a pointer to the source image
+ * @ksize: the size of the kernel
+ * @mode: the edge mode
+ * @out: receives up to four affected rectangles of the output image
+ * Return: the number of rectangles written to out
+ */
+
+size_t dirty_expand(rect_t const *dirty, img_t const *img, size_t ksize,
+		    edge_mode_t mode, rect_t *out)
+{
+	long lo[2], hi[2], seg[2][4], r = ksize / 2, t = ksize - 1 - r, n;
+	size_t nseg[2], a, i, j, k = 0;
+
+	lo[0] = (long)dirty->x - t, hi[0] = (long)(dirty->x + dirty->w) + r;
+	lo[1] = (long)dirty->y - t, hi[1] = (long)(dirty->y + dirty->h) + r;
+	for (a = 0; a < 2; a++)
+	{
+		n = a ? (long)img->h : (long)img->w;
+		seg[a][0] = lo[a] < 0 ? 0 : lo[a];
+		seg[a][1] = hi[a] > n ? n : hi[a], nseg[a] = 1;
+		if (mode != EDGE_WRAP || hi[a] - lo[a] >= n)
+			continue;
+		if (lo[a] < 0)
+			seg[a][2] = n + lo[a], seg[a][3] = n, nseg[a] = 2;
+		else if (hi[a] > n)
+			seg[a][2] = 0, seg[a][3] = hi[a] - n, nseg[a] = 2;
+	}
+	for (i = 0; i < nseg[0]; i++)
+		for (j = 0; j < nseg[1]; j++)
+		{
+			if (seg[0][2 * i] >= seg[0][2 * i + 1] ||
+			    seg[1][2 * j] >= seg[1][2 * j + 1])
+				continue;
+			out[k].x = seg[0][2 * i];
+			out[k].w = seg[0][2 * i + 1] - seg[0][2 * i];
+			out[k].y = seg[1][2 * j];
+			out[k++].h = seg[1][2 * j + 1] - seg[1][2 * j];
+		}
+	return (k);
+}
+
+/**
+ * dirty_merge - program that merges overlapping or adjacent rectangles
+ * into their bounding boxes, until no two rectangles touch, so that no
+ * output pixel is blurred twice
+ * @rects: the rectangles, merged in place
+ * @count: the number of rectangles
+ * Return: the number of rectangles left
+ */
+
+size_t dirty_merge(rect_t *rects, size_t count)
+{
+	size_t i, j, x1, y1;
+	rect_t *a, *b;
+	int merged;
+
+	do {
+		merged = 0;
+		for (i = 0; i < count; i++)
+			for (j = i + 1; j < count; )
+			{
+				a = rects + i, b = rects + j;
+				if (a->x > b->x + b->w || b->x > a->x + a->w ||
+				    a->y > b->y + b->h || b->y > a->y + a->h)
+				{
+					j++;
+					continue;
+				}
+				x1 = MAX(a->x + a->w, b->x + b->w);
+				y1 = MAX(a->y + a->h, b->y + b->h);
+				a->x = MIN(a->x, b->x), a->y = MIN(a->y, b->y);
+				a->w = x1 - a->x, a->h = y1 - a->y;
+				*b = rects[--count], merged = 1;
+			}
+	} while (merged);
+	return (count);
+}
+
+/**
+ * dirty_job - pool job program that re-blurs one tile of the affected
+ * output pixels with the edge mode it carries
+ * @arg: a pointer to the dirty_job_t describing the job
+ * @i: the index of the tile
+ * Return: nothing (void)
+ */
+
+static void dirty_job(void *arg, size_t i)
+{
+	dirty_job_t const *job = arg;
+	blur_portion_t const *tile = job->tiles + i;
+
+	if (job->fixed)
+		blur_portion_fixed(tile, job->ck, tile->edge);
+	else
+		blur_portion_ck_edge(tile, job->ck, tile->edge);
+}
+
+/**
+ * dirty_tiles - program that covers rectangles of an image with tiles
+ * @rects: the rectangles, which do not overlap
+ * @count: the number of rectangles
+ * @proto: a portion whose img, img_blur, kernel and edge are copied into
+ *         every tile
+ * @opts: the blur options; tile_w and tile_h of 0 select blur_tile_size
+ *        for every rectangle
+ * @ntiles: receives the number of tiles
+ * Return: the tiles, to be released with free, or NULL on failure
+ */
+
+static blur_portion_t *dirty_tiles(rect_t const *rects, size_t count,
+				   blur_portion_t const *proto,
+				   blur_opts_t const *opts, size_t *ntiles)
+{
+	blur_portion_t *tiles = NULL;
+	size_t pass, i, x, y, tw, th, n;
+
+	for (pass = 0; pass < 2; pass++)
+	{
+		for (i = 0, n = 0; i < count; i++)
+		{
+			blur_tile_size(rects[i].w, rects[i].h,
+				       proto->kernel->size, &tw, &th);
+			tw = opts->tile_w ? opts->tile_w : tw;
+			th = opts->tile_h ? opts->tile_h : th;
+			for (y = 0; y < rects[i].h; y += th)
+				for (x = 0; x < rects[i].w; x += tw, n++)
+				{
+					if (!tiles)
+						continue;
+					tiles[n] = *proto;
+					tiles[n].x = rects[i].x + x;
+					tiles[n].y = rects[i].y + y;
+					tiles[n].w = MIN(tw, rects[i].w - x);
+					tiles[n].h = MIN(th, rects[i].h - y);
+				}
+		}
+		if (!pass && !(tiles = malloc(sizeof(*tiles) * (n ? n : 1))))
+			return (NULL);
+	}
+	*ntiles = n;
+	return (tiles);
+}
+
+/**
+ * blur_image_dirty - program that re-blurs only the output pixels of an
+ * image affected by changed rectangles of its source
+ * every changed rectangle is grown by the kernel reach (see
+ * dirty_expand), the results are merged so that no output pixel is
+ * blurred twice, and the merged rectangles are cut into tiles re-blurred
+ * on the blur pool by blur_portion_ck_edge, or blur_portion_fixed with
+ * opts->fixed, the portion programs of the tiled path of blur_image_opts;
+ * opts->planar is ignored, and kernels that blur_image_opts would send
+ * through the FFT are still convolved directly; every other output pixel
+ * is left untouched and must hold the blur of the unchanged source, e.g.
+ * from a previous call to blur_image_opts
+ * @img_blur: a pointer to the output image data structure
+ * @img: a pointer to the changed input image data structure
+ * @kernel: a pointer to the convolution kernel
+ * @opts: a pointer to the blur options, NULL for the defaults
+ * @dirty: the changed rectangles of img, which may overlap
+ * @count: the number of changed rectangles
+ * Return: 1 on success, 0 on failure
+ */
+
+int blur_image_dirty(img_t *img_blur, img_t const *img,
+		     kernel_t const *kernel, blur_opts_t const *opts,
+		     rect_t const *dirty, size_t count)
+{
+	blur_opts_t defaults = {EDGE_RENORMALIZE, 0, 0, 0, 0};
+	rect_t *rects = malloc(sizeof(rect_t) * 4 * (count ? count : 1));
+	blur_portion_t proto;
+	dirty_job_t job;
+	size_t i, n = 0;
+
+	opts = opts ? opts : &defaults;
+	job.ck = rects ? kernel_compile(kernel) : NULL;
+	job.fixed = opts->fixed, job.tiles = NULL;
+	proto.img = img, proto.img_blur = img_blur, proto.x = proto.y = 0;
+	proto.w = proto.h = 0, proto.edge = opts->edge;
+	proto.kernel = job.ck ? &job.ck->kernel : kernel;
+	for (i = 0; job.ck && i < count; i++)
+		if (dirty[i].w && dirty[i].h)
+			n += dirty_expand(dirty + i, img, kernel->size,
+					  opts->edge, rects + n);
+	n = dirty_merge(rects, n);
+	if (job.ck)
+		job.tiles = dirty_tiles(rects, n, &proto, opts, &n);
+	if (job.tiles)
+		blur_pool_run(n, dirty_job, &job);
+	else
+		fprintf(stderr, "blur_image_dirty: out of memory\n");
+	free(job.tiles);
+	free(rects);
+	kernel_free(job.ck);
+	return (job.tiles != NULL);
+}
@@ -0,0 +1,165 @@
+#include "multithreading.h"
+
+#include <string.h>
+
+/**
+ * edge_index - program that maps a row or column index falling outside of
+ * the image back inside it according to an edge mode
+ * @i: the index to map, possibly negative or past the end of the image
+ * @n: the size of the image along the mapped axis
+ * @mode: the edge mode (EDGE_RENORMALIZE is mapped like EDGE_CLAMP)
+ * Return: the mapped index, in [0, n)
+ */
+
+size_t edge_index(long i, size_t n, edge_mode_t mode)
+{
+	long len = (long)n, m;
+
+	if (mode == EDGE_WRAP)
+		return (((i % len) + len) % len);
+	if (mode == EDGE_MIRROR)
+	{
+		m = ((i % (2 * len)) + 2 * len) % (2 * len);
+		return (m < len ? m : 2 * len - 1 - m);
+	}
+	return (i < 0 ? 0 : (i >= len ? n - 1 : (size_t)i));
+}
+
+/**
+ * halo_build - program that copies a rectangle of an image surrounded by
+ * a halo of kernel_size / 2 pixels into a padded buffer
+ * the halo pixels are fetched through the edge mode, so that a blur of
+ * the padded buffer never has to check a tap against the image bounds
+ * @strip: the rectangle of the image to copy, with its kernel
+ * @mode: the edge mode used to fill the halo
+ * @pad: a pointer to the padded image, whose w and h are already set
+ * @xmap: a buffer of pad->w columns, receives the column map
+ * Return: nothing (void)
+ */
+
+static void halo_build(blur_portion_t const *strip, edge_mode_t mode,
+		       img_t *pad, size_t *xmap)
+{
+	long r = strip->kernel->size / 2;
+	size_t px, py, sy;
+	pixel_t const *src;
+	pixel_t *dst = pad->pixels;
+
+	for (px = 0; px < pad->w; px++)
+		xmap[px] = edge_index((long)(strip->x + px) - r, strip->img->w,
+				      mode);
+	for (py = 0; py < pad->h; py++, dst += pad->w)
+	{
+		sy = edge_index((long)(strip->y + py) - r, strip->img->h, mode);
+		src = strip->img->pixels + sy * strip->img->w;
+		for (px = 0; px < pad->w; px++)
+			dst[px] = src[xmap[px]];
+	}
+}
+
+/**
+ * halo_blur - program that blurs a rectangle of an image through a padded
+ * halo built with an edge mode
+ * the padded copy is blurred with blur_portion_ck, where every tap falls
+ * inside the padded buffer, so the weights are normalized by the kernel
+ * sum; the blurred rows are then copied to the destination image; if the
+ * padded buffer cannot be allocated, the failure is reported and the
+ * rectangle is blurred by blur_portion_ck on the image itself, which
+ * needs no memory but renormalizes the weights at the borders
+ * @strip: the rectangle of the image to blur
+ * @ck: a pointer to the compiled kernel
+ * @mode: the edge mode used to fill the halo
+ * Return: nothing (void)
+ */
+
+static void halo_blur(blur_portion_t const *strip, ckernel_t const *ck,
+		      edge_mode_t mode)
+{
+	size_t size = ck->size, y, *xmap;
+	img_t pad, out;
+	blur_portion_t sub;
+
+	if (!strip->w || !strip->h)
+		return;
+	pad.w = out.w = strip->w + size - 1;
+	pad.h = out.h = strip->h + size - 1;
+	xmap = malloc(sizeof(size_t) * pad.w +
+		      sizeof(pixel_t) * pad.w * pad.h * 2);
+	if (!xmap)
+	{
+		fprintf(stderr, "blur_portion_ck_edge: out of memory\n");
+		blur_portion_ck(strip, ck);
+		return;
+	}
+	pad.pixels = (pixel_t *)(xmap + pad.w);
+	out.pixels = pad.pixels + pad.w * pad.h;
+	halo_build(strip, mode, &pad, xmap);
+	sub = *strip;
+	sub.img = &pad, sub.img_blur = &out;
+	sub.x = size / 2, sub.y = size / 2;
+	blur_portion_ck(&sub, ck);
+	for (y = 0; y < strip->h; y++)
+		memcpy(strip->img_blur->pixels +
+		       (strip->y + y) * strip->img_blur->w + strip->x,
+		       out.pixels + (sub.y + y) * out.w + sub.x,
+		       sizeof(pixel_t) * strip->w);
+	free(xmap);
+}
+
+/**
+ * blur_portion_ck_edge - program that blurs a portion of an image with a
+ * compiled kernel and a selectable behavior at the borders of the image
+ * the portion is split into an interior rectangle, whose taps all fall
+ * inside the image and which goes through the branch-free paths of
+ * blur_portion_ck, and at most four thin border strips; with EDGE_CLAMP,
+ * EDGE_MIRROR and EDGE_WRAP the strips are blurred through a padded halo,
+ * with EDGE_RENORMALIZE the out-of-bounds taps are dropped and the weights
+ * renormalized, like blur_portion does
+ * @portion: a pointer to the portion of the image to blur
+ * @ck: a pointer to the compiled kernel
+ * @mode: the edge mode
+ * Return: nothing (void)
+ */
+
+void blur_portion_ck_edge(blur_portion_t const *portion, ckernel_t const *ck,
+			  edge_mode_t mode)
+{
+	blur_portion_t in, s[4];
+	size_t i;
+
+	if (mode == EDGE_RENORMALIZE)
+	{
+		blur_portion_ck(portion, ck);
+		return;
+	}
+	if (!portion_interior(portion, ck->size, &in, s))
+	{
+		halo_blur(portion, ck, mode);
+		return;
+	}
+	blur_portion_ck(&in, ck);
+	for (i = 0; i < 4; i++)
+		halo_blur(s + i, ck, mode);
+}
+
+/**
+ * blur_portion_edge - program that blurs a portion of an image with a
+ * selectable behavior at the borders of the image
+ * the kernel is compiled once per thread, see kernel_cached and
+ * blur_portion_ck_edge
+ * @portion: a pointer to the portion of the image to blur
+ * @mode: the edge mode
+ * Return: nothing (void)
+ */
+
+void blur_portion_edge(blur_portion_t const *portion, edge_mode_t mode)
+{
+	ckernel_t const *ck = kernel_cached(portion->kernel);
+
+	if (!ck)
+	{
+		fprintf(stderr, "blur_portion_edge: kernel_compile failed\n");
+		return;
+	}
+	blur_portion_ck_edge(portion, ck, mode);
+}
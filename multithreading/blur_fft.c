@@ -0,0 +1,179 @@
+#include "multithreading.h"
+
+#include <math.h>
+#include <string.h>
+
+#define FFT_MAX_N 2048
+#define FFT_TAP_COST 1.0
+#define FFT_BUTTERFLY_COST 7.0
+
+/**
+ * fft_transform - program that runs in place a radix-2 FFT of size f->n
+ * over several interleaved sequences at once
+ * element e of sequence c lives at index e * stride + c, so a call with
+ * count 1 and stride 1 transforms one contiguous row, and a call with
+ * count and stride n transforms every column of an n x n array with
+ * contiguous inner loops; the inverse transform is not scaled
+ * @f: a pointer to the FFT
+ * @re: the real parts of the sequences
+ * @im: the imaginary parts of the sequences
+ * @stride: the distance between two elements of a sequence
+ * @count: the number of sequences, at most stride
+ * @inverse: 1 for the inverse transform, 0 for the forward one
+ * Return: nothing (void)
+ */
+
+void fft_transform(fft_t const *f, double *re, double *im, size_t stride,
+		   size_t count, int inverse)
+{
+	size_t n = f->n, i, j, k, len, a, b, c;
+	double tr, ti, wr, wi;
+
+	for (i = 1, j = 0; i < n; i++)
+	{
+		for (k = n >> 1; j & k; k >>= 1)
+			j ^= k;
+		j |= k;
+		for (c = 0; i < j && c < count; c++)
+		{
+			a = i * stride + c, b = j * stride + c;
+			tr = re[a], re[a] = re[b], re[b] = tr;
+			ti = im[a], im[a] = im[b], im[b] = ti;
+		}
+	}
+	for (len = 2; len <= n; len <<= 1)
+		for (i = 0; i < n; i += len)
+			for (k = 0; k < len / 2; k++)
+			{
+				wr = f->cos[k * (n / len)];
+				wi = inverse ? f->sin[k * (n / len)] :
+					-f->sin[k * (n / len)];
+				a = (i + k) * stride, b = a + len / 2 * stride;
+				for (c = 0; c < count; c++, a++, b++)
+				{
+					tr = re[b] * wr - im[b] * wi;
+					ti = re[b] * wi + im[b] * wr;
+					re[b] = re[a] - tr, im[b] = im[a] - ti;
+					re[a] += tr, im[a] += ti;
+				}
+			}
+}
+
+/**
+ * kernel_fft_size - program that weighs the FFT convolution of a kernel
+ * against its direct or separable convolution
+ * a tile of n x n costs four 2D transforms of n^2 log2(n) butterflies
+ * each for (n - size + 1)^2 output pixels, against ntaps (or 2 * size for
+ * a separable kernel) multiply-adds per pixel, a butterfly weighing about
+ * as much as FFT_BUTTERFLY_COST vectorized taps; among the sizes whose cost
+ * is within a quarter of the best one, the smallest is picked to keep the
+ * tiles in cache
+ * @ck: a pointer to the compiled kernel
+ * Return: the size of the FFT to convolve with, or 0 if the direct or
+ *         separable convolution is cheaper
+ */
+
+size_t kernel_fft_size(ckernel_t const *ck)
+{
+	double cost[32], best = 0, m;
+	size_t n0, n, k;
+
+	for (n0 = 2; n0 < 2 * ck->size; n0 <<= 1)
+		;
+	if (n0 > FFT_MAX_N)
+		return (0);
+	for (n = n0, k = 0; n <= FFT_MAX_N; n <<= 1, k++)
+	{
+		m = (double)(n - ck->size + 1);
+		cost[k] = 4 * FFT_BUTTERFLY_COST * n * n * log2((double)n) /
+			  (m * m);
+		best = !k || cost[k] < best ? cost[k] : best;
+	}
+	for (n = n0, k = 0; cost[k] > 1.25 * best; k++)
+		n <<= 1;
+	m = FFT_TAP_COST * (ck->separable ? 2.0 * ck->size : ck->ntaps);
+	if (cost[k] >= m)
+		return (0);
+	return (n);
+}
+
+/**
+ * fft_spectrum - program that computes the spectrum of a kernel and the
+ * summed-area table of its weights
+ * the kernel is mirrored around the origin of the transform, so that the
+ * product of spectra computes the same correlation as blur_portion
+ * @f: a pointer to the FFT, whose arrays are laid out
+ * @ck: a pointer to the compiled kernel
+ * Return: nothing (void)
+ */
+
+static void fft_spectrum(fft_t *f, ckernel_t const *ck)
+{
+	size_t n = f->n, s = ck->size, i, j;
+	double *sat = f->sat;
+
+	memset(f->kre, 0, sizeof(double) * n * n * 2);
+	for (i = 0; i < s; i++)
+		for (j = 0; j < s; j++)
+			f->kre[(n - i) % n * n + (n - j) % n] =
+				ck->weights[i * s + j];
+	for (i = 0; i < n; i++)
+		fft_transform(f, f->kre + i * n, f->kim + i * n, 1, 1, 0);
+	fft_transform(f, f->kre, f->kim, n, n, 0);
+	for (i = 0; i <= s; i++)
+		for (j = 0; j <= s; j++)
+			sat[i * (s + 1) + j] = !i || !j ? 0 :
+				ck->weights[(i - 1) * s + j - 1] +
+				sat[(i - 1) * (s + 1) + j] +
+				sat[i * (s + 1) + j - 1] -
+				sat[(i - 1) * (s + 1) + j - 1];
+}
+
+/**
+ * kernel_fft - program that prepares the FFT convolution of a kernel
+ * @ck: a pointer to the compiled kernel
+ * @n: the size of the transform, a power of two of at least ck->size
+ * Return: a pointer to the FFT, to be released with fft_free, or NULL on
+ *         failure
+ */
+
+fft_t *kernel_fft(ckernel_t const *ck, size_t n)
+{
+	fft_t *f = malloc(sizeof(*f));
+	size_t i;
+
+	if (!f)
+		return (NULL);
+	f->n = n, f->m = n - ck->size + 1;
+	f->cos = malloc(sizeof(double) * (n + 2 * n * n +
+					  (ck->size + 1) * (ck->size + 1)));
+	if (!f->cos)
+	{
+		free(f);
+		return (NULL);
+	}
+	f->sin = f->cos + n / 2;
+	f->kre = f->sin + n / 2, f->kim = f->kre + n * n;
+	f->sat = f->kim + n * n;
+	for (i = 0; i < n / 2; i++)
+	{
+		f->cos[i] = cos(2 * M_PI * i / n);
+		f->sin[i] = sin(2 * M_PI * i / n);
+	}
+	fft_spectrum(f, ck);
+	return (f);
+}
+
+/**
+ * fft_free - program that releases an FFT
+ * @f: a pointer to the FFT, may be NULL
+ * Return: nothing (void)
+ */
+
+void fft_free(fft_t *f)
+{
+	if (!f)
+		return;
+	free(f->cos);
+	free(f);
+}
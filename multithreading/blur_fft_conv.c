@@ -0,0 +1,220 @@
+#include "multithreading.h"
+
+#include <string.h>
+
+#define FFT_EPSILON 1e-6
+#define FFT_CLAMP(v) ((v) <= 0 ? 0 : (v) >= 255 ? 255 : \
+		      (uint8_t)((v) + FFT_EPSILON))
+
+/**
+ * struct fft_job_s - Argument of the pool jobs of an FFT convolution
+ * @img:      the source image
+ * @img_blur: the destination image
+ * @ck:       the compiled kernel
+ * @f:        the FFT, with the spectrum of the kernel
+ * @edge:     the edge mode
+ * @failed:   set by a job that could not allocate its buffers
+ */
+
+typedef struct fft_job_s
+{
+	img_t const *img;
+	img_t *img_blur;
+	ckernel_t const *ck;
+	fft_t const *f;
+	edge_mode_t edge;
+	int failed;
+} fft_job_t;
+
+/**
+ * fft_load - program that loads the source tile of an output tile, red
+ * and green as the real and imaginary parts of one sequence and blue as
+ * the real part of another
+ * the tile is grown by the kernel halo, fetched through the edge mode, or
+ * left black outside of the image with EDGE_RENORMALIZE
+ * @job: a pointer to the job
+ * @x0: the first column of the output tile
+ * @y0: the first row of the output tile
+ * @buf: the four n x n arrays of the two sequences, then n column indices
+ * Return: nothing (void)
+ */
+
+static void fft_load(fft_job_t const *job, long x0, long y0, double *buf)
+{
+	size_t n = job->f->n, nn = n * n, i, j;
+	long r = job->ck->size / 2, W = job->img->w, H = job->img->h, u, *map;
+	pixel_t const *row;
+
+	memset(buf, 0, sizeof(double) * 4 * nn);
+	map = (long *)(buf + 4 * nn);
+	for (i = 0; i < n; i++)
+	{
+		u = x0 - r + (long)i;
+		map[i] = job->edge == EDGE_RENORMALIZE && (u < 0 || u >= W) ?
+			-1 : (long)edge_index(u, W, job->edge);
+	}
+	for (j = 0; j < n; j++)
+	{
+		u = y0 - r + (long)j;
+		if (job->edge == EDGE_RENORMALIZE && (u < 0 || u >= H))
+			continue;
+		row = job->img->pixels + edge_index(u, H, job->edge) * W;
+		for (i = 0; i < n; i++)
+			if (map[i] >= 0)
+			{
+				buf[j * n + i] = row[map[i]].r;
+				buf[nn + j * n + i] = row[map[i]].g;
+				buf[2 * nn + j * n + i] = row[map[i]].b;
+			}
+	}
+}
+
+/**
+ * fft_store - program that writes an output tile, dividing every pixel
+ * by the scale of the inverse transform and by the kernel weights its
+ * taps covered
+ * with EDGE_RENORMALIZE the weights of the taps falling inside the image
+ * are read from the summed-area table of the kernel
+ * @job: a pointer to the job
+ * @x0: the first column of the output tile
+ * @y0: the first row of the output tile
+ * @buf: the four n x n arrays of the two convolved sequences
+ * Return: nothing (void)
+ */
+
+static void fft_store(fft_job_t const *job, long x0, long y0,
+		      double const *buf)
+{
+	size_t n = job->f->n, nn = n * n, i, j;
+	long s = job->ck->size, r = s / 2, W = job->img->w, H = job->img->h;
+	long x, y, a, b, c, d;
+	double const *sat = job->f->sat;
+	double w;
+	pixel_t *dst;
+
+	for (j = 0; j < job->f->m && (y = y0 + (long)j) < H; j++)
+		for (i = 0; i < job->f->m && (x = x0 + (long)i) < W; i++)
+		{
+			a = r - y > 0 ? r - y : 0, b = H + r - y;
+			c = r - x > 0 ? r - x : 0, d = W + r - x;
+			b = b < s ? b : s, d = d < s ? d : s;
+			w = job->ck->sum;
+			if (job->edge == EDGE_RENORMALIZE &&
+			    (a || c || b < s || d < s))
+			{
+				a *= s + 1, b *= s + 1;
+				w = sat[b + d] - sat[a + d] - sat[b + c] +
+				    sat[a + c];
+			}
+			w *= (double)nn;
+			dst = job->img_blur->pixels + y * W + x;
+			dst->r = FFT_CLAMP(buf[j * n + i] / w);
+			dst->g = FFT_CLAMP(buf[nn + j * n + i] / w);
+			dst->b = FFT_CLAMP(buf[2 * nn + j * n + i] / w);
+		}
+}
+
+/**
+ * fft_tile - program that convolves one tile sequence with the kernel
+ * only the rows of the output tile go through the last inverse pass
+ * @f: a pointer to the FFT, with the spectrum of the kernel
+ * @re: the real parts of the n x n sequence
+ * @im: the imaginary parts of the n x n sequence
+ * Return: nothing (void)
+ */
+
+static void fft_tile(fft_t const *f, double *re, double *im)
+{
+	size_t n = f->n, i;
+	double t;
+
+	for (i = 0; i < n; i++)
+		fft_transform(f, re + i * n, im + i * n, 1, 1, 0);
+	fft_transform(f, re, im, n, n, 0);
+	for (i = 0; i < n * n; i++)
+	{
+		t = re[i] * f->kre[i] - im[i] * f->kim[i];
+		im[i] = re[i] * f->kim[i] + im[i] * f->kre[i];
+		re[i] = t;
+	}
+	fft_transform(f, re, im, n, n, 1);
+	for (i = 0; i < f->m; i++)
+		fft_transform(f, re + i * n, im + i * n, 1, 1, 1);
+}
+
+/**
+ * fft_job - pool job program that convolves one row of output tiles
+ * every tile is loaded, transformed, multiplied by the spectrum of the
+ * kernel and transformed back; the valid part of the circular convolution
+ * is the output tile (overlap-save), so tiles never write over each
+ * other; a job that cannot allocate its buffers marks the convolution as
+ * failed, its row of tiles being left unwritten
+ * @arg: a pointer to the fft_job_t describing the convolution
+ * @ty: the index of the row of tiles
+ * Return: nothing (void)
+ */
+
+static void fft_job(void *arg, size_t ty)
+{
+	fft_job_t *job = arg;
+	size_t nn = job->f->n * job->f->n, x0;
+	double *buf = malloc(sizeof(double) * 4 * nn +
+			     sizeof(long) * job->f->n);
+
+	for (x0 = 0; buf && x0 < job->img->w; x0 += job->f->m)
+	{
+		fft_load(job, x0, ty * job->f->m, buf);
+		fft_tile(job->f, buf, buf + nn);
+		fft_tile(job->f, buf + 2 * nn, buf + 3 * nn);
+		fft_store(job, x0, ty * job->f->m, buf);
+	}
+	if (!buf)
+	{
+		fprintf(stderr, "blur_image_fft: out of memory\n");
+		__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+	}
+	free(buf);
+}
+
+/**
+ * blur_image_fft - program that blurs an entire image through the FFT
+ * the image is cut into output tiles of n - size + 1 pixels, convolved
+ * with n x n transforms (overlap-save) on the blur pool, a row of tiles
+ * per job; the spectrum of the kernel is computed once and cached in the
+ * compiled kernel, so it is only reused by the callers that keep the
+ * compiled kernel across calls (see blur_image_ck): blur_image and
+ * blur_image_opts compile the kernel, and so transform it, at every call;
+ * on failure some of the output may have been written, and the caller
+ * must blur the image again some other way
+ * @img_blur: a pointer to the output image data structure
+ * @img: a pointer to the input image data structure
+ * @ck: a pointer to the compiled kernel
+ * @opts: a pointer to the blur options, NULL for the defaults
+ * Return: 1 on success, 0 on failure
+ */
+
+int blur_image_fft(img_t *img_blur, img_t const *img, ckernel_t const *ck,
+		   blur_opts_t const *opts)
+{
+	fft_t *f = __atomic_load_n(&ck->fft, __ATOMIC_ACQUIRE), *none = NULL;
+	fft_job_t job;
+	size_t n;
+
+	if (!f)
+	{
+		n = kernel_fft_size(ck);
+		for (n = n ? n : 2; n < 2 * ck->size; n <<= 1)
+			;
+		f = kernel_fft(ck, n);
+		if (!f)
+			return (0);
+		if (!__atomic_compare_exchange_n(&((ckernel_t *)ck)->fft,
+						 &none, f, 0, __ATOMIC_ACQ_REL,
+						 __ATOMIC_ACQUIRE))
+			fft_free(f), f = none;
+	}
+	job.img = img, job.img_blur = img_blur, job.ck = ck, job.f = f;
+	job.edge = opts ? opts->edge : EDGE_RENORMALIZE, job.failed = 0;
+	blur_pool_run((img->h + f->m - 1) / f->m, fft_job, &job);
+	return (!job.failed);
+}
@@ -0,0 +1,213 @@
+#include "multithreading.h"
+
+#define FIXED_SHIFT_MAX 14
+#define FIXED_SEPARABLE_RATIO 5
+#define ABSL(v) ((v) < 0 ? -(v) : (v))
+#define ROUNDL(v) ((v) < 0 ? -(long)(0.5f - (v)) : (long)((v) + 0.5f))
+
+/**
+ * struct fixed_taps_s - Non-zero fixed-point taps of a compiled kernel,
+ * laid out for the byte rows of one image
+ * @offs:  offset of every tap, in bytes, relative to the output byte
+ * @q:     fixed-point weight of every tap
+ * @n:     number of taps, padded to an even number with a zero weight
+ * @shift: number of fractional bits of the weights
+ */
+
+typedef struct fixed_taps_s
+{
+	long *offs;
+	int16_t *q;
+	size_t n;
+	int shift;
+} fixed_taps_t;
+
+/**
+ * kernel_quantize - program that converts the weights of a compiled kernel
+ * to 16-bit fixed point
+ * the weights are normalized by the kernel sum and scaled by 1 << shift,
+ * the rounding error being folded into the largest weight so that they add
+ * up to exactly 1 << shift; the largest shift is picked for which every
+ * weight fits in 16 bits and a sum of 8-bit samples fits in 32 bits
+ * @ck: a pointer to the compiled kernel, whose taps are already set
+ * Return: nothing (void)
+ */
+
+void kernel_quantize(ckernel_t *ck)
+{
+	long q, total, mag;
+	size_t t, big;
+	int shift;
+
+	ck->qshift = 0;
+	if (ck->sum == 0 || !ck->ntaps)
+		return;
+	for (shift = FIXED_SHIFT_MAX; shift > 0; shift--)
+	{
+		for (t = 0, total = mag = 0, big = 0; t < ck->ntaps; t++)
+		{
+			q = ROUNDL(ck->tap_w[t] / ck->sum * (1L << shift));
+			if (ABSL(q) > INT16_MAX)
+				break;
+			ck->tap_q[t] = q, total += q, mag += ABSL(q);
+			big = ABSL(q) > ABSL(ck->tap_q[big]) ? t : big;
+		}
+		if (t < ck->ntaps)
+			continue;
+		q = ck->tap_q[big] + (1L << shift) - total;
+		mag += ABSL(q) - ABSL(ck->tap_q[big]);
+		if (ABSL(q) > INT16_MAX || mag > (INT32_MAX >> 8))
+			continue;
+		ck->tap_q[big] = q;
+		ck->qshift = shift;
+		return;
+	}
+}
+
+/**
+ * portion_interior - program that splits a portion of an image into the
+ * rectangle whose kernel taps all fall inside the image and the at most
+ * four border strips around it
+ * @portion: a pointer to the portion to split
+ * @size: the size of the kernel
+ * @in: receives the interior rectangle
+ * @s: receive the top, bottom, left and right strips, possibly empty
+ * Return: 1 if the interior rectangle is not empty, 0 otherwise
+ */
+
+int portion_interior(blur_portion_t const *portion, size_t size,
+		     blur_portion_t *in, blur_portion_t s[4])
+{
+	size_t r = size / 2, t = size - 1 - r, i;
+	size_t x1 = portion->x + portion->w, y1 = portion->y + portion->h;
+	size_t xe = portion->img->w > t ? portion->img->w - t : 0;
+	size_t ye = portion->img->h > t ? portion->img->h - t : 0;
+
+	*in = *portion;
+	in->x = portion->x > r ? portion->x : r;
+	in->y = portion->y > r ? portion->y : r;
+	in->w = xe < x1 ? xe : x1;
+	in->h = ye < y1 ? ye : y1;
+	if (in->w <= in->x || in->h <= in->y)
+		return (0);
+	in->w -= in->x, in->h -= in->y;
+	for (i = 0; i < 4; i++)
+		s[i] = *portion;
+	s[0].h = in->y - portion->y;
+	s[1].y = in->y + in->h, s[1].h = y1 - s[1].y;
+	s[2].y = s[3].y = in->y, s[2].h = s[3].h = in->h;
+	s[2].w = in->x - portion->x;
+	s[3].x = in->x + in->w, s[3].w = x1 - s[3].x;
+	return (1);
+}
+
+/**
+ * fixed_taps - program that lays out the non-zero fixed-point taps of a
+ * compiled kernel for the byte rows of an image
+ * an RGB row is handled as a row of bytes, where the tap dx of a channel
+ * sits 3 * dx bytes away, so the three channels need no deinterleaving
+ * @ft: receives the taps, ft->offs to be released with free
+ * @ck: a pointer to the compiled kernel
+ * @w: the width of the image
+ * Return: 1 on success, 0 on failure
+ */
+
+static int fixed_taps(fixed_taps_t *ft, ckernel_t const *ck, size_t w)
+{
+	size_t t;
+
+	ft->offs = malloc((sizeof(long) + sizeof(int16_t)) * (ck->ntaps + 1));
+	if (!ft->offs)
+		return (0);
+	ft->q = (int16_t *)(ft->offs + ck->ntaps + 1);
+	ft->shift = ck->qshift;
+	for (t = 0, ft->n = 0; t < ck->ntaps; t++)
+	{
+		if (!ck->tap_q[t])
+			continue;
+		ft->offs[ft->n] = 3 * (ck->tap_y[t] * (long)w + ck->tap_x[t]);
+		ft->q[ft->n++] = ck->tap_q[t];
+	}
+	if (ft->n % 2)
+	{
+		ft->offs[ft->n] = ft->offs[0];
+		ft->q[ft->n++] = 0;
+	}
+	return (1);
+}
+
+/**
+ * fixed_span - program that convolves a span of bytes with fixed-point
+ * taps, accumulating in 32-bit integers and rounding back with a shift
+ * the bulk of the span goes through the widest integer instruction set
+ * selected, the remaining bytes one at a time
+ * @src: a pointer to the source byte of the first output byte
+ * @ft: a pointer to the fixed-point taps
+ * @n: the number of output bytes
+ * @dst: receives the output bytes, clamped to [0, 255]
+ * Return: nothing (void)
+ */
+
+static void fixed_span(uint8_t const *src, fixed_taps_t const *ft, size_t n,
+		       uint8_t *dst)
+{
+	size_t i = 0, t;
+	int32_t acc;
+
+#if defined(__x86_64__) || defined(__i386__)
+	if (blur_simd_level() >= SIMD_AVX2)
+		i = fixed_span_avx2(src, ft->offs, ft->q, ft->n, ft->shift, n,
+				    dst);
+	else if (blur_simd_level() >= SIMD_SSE41)
+		i = fixed_span_sse41(src, ft->offs, ft->q, ft->n, ft->shift, n,
+				     dst);
+#endif
+	for (; i < n; i++)
+	{
+		acc = 1 << (ft->shift - 1);
+		for (t = 0; t < ft->n; t++)
+			acc += ft->q[t] * src[i + ft->offs[t]];
+		acc >>= ft->shift;
+		dst[i] = acc < 0 ? 0 : (acc > 255 ? 255 : acc);
+	}
+}
+
+/**
+ * blur_portion_fixed - program that blurs a portion of an image with the
+ * fixed-point weights of a compiled kernel
+ * the interior rectangle, whose taps all fall inside the image, is
+ * convolved in 32-bit integers with no division per pixel, and rounds to
+ * nearest instead of truncating; the thin border strips go through
+ * blur_portion_ck_edge, as does the whole portion when the kernel could
+ * not be quantized or is separable and large enough for the two 1D
+ * passes in float to beat the 2D convolution in fixed point
+ * @portion: a pointer to the portion of the image to blur
+ * @ck: a pointer to the compiled kernel
+ * @mode: the edge mode of the border strips
+ * Return: nothing (void)
+ */
+
+void blur_portion_fixed(blur_portion_t const *portion, ckernel_t const *ck,
+			edge_mode_t mode)
+{
+	blur_portion_t in, s[4];
+	fixed_taps_t ft;
+	size_t y, i, w = portion->img->w;
+	uint8_t const *src = (uint8_t const *)portion->img->pixels;
+	uint8_t *dst = (uint8_t *)portion->img_blur->pixels;
+
+	if (!ck->qshift || (ck->separable &&
+			    ck->ntaps > FIXED_SEPARABLE_RATIO * 2 * ck->size) ||
+	    !portion_interior(portion, ck->size, &in, s) ||
+	    !fixed_taps(&ft, ck, w))
+	{
+		blur_portion_ck_edge(portion, ck, mode);
+		return;
+	}
+	for (y = in.y; y < in.y + in.h; y++)
+		fixed_span(src + 3 * (y * w + in.x), &ft, 3 * in.w,
+			   dst + 3 * (y * portion->img_blur->w + in.x));
+	free(ft.offs);
+	for (i = 0; i < 4; i++)
+		blur_portion_ck_edge(s + i, ck, mode);
+}
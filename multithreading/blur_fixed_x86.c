@@ -0,0 +1,106 @@
+#include "multithreading.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#define LOAD64(p) _mm_loadl_epi64((__m128i const *)(p))
+#define U8_EPI16(p) _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i const *)(p)))
+#define MADD128(acc, a, w) _mm_add_epi32((acc), _mm_madd_epi16((a), (w)))
+#define MADD256(acc, a, w) \
+	_mm256_add_epi32((acc), _mm256_madd_epi16((a), (w)))
+#define PAIR(q, t) ((int)((uint32_t)(uint16_t)(q)[t] | \
+			  (uint32_t)(uint16_t)(q)[(t) + 1] << 16))
+
+/**
+ * fixed_span_sse41 - program that convolves a span of bytes with pairs of
+ * fixed-point taps, 8 output bytes per iteration with SSE4.1
+ * the samples of two taps are interleaved as 16-bit words so that one
+ * pmaddwd multiplies and adds both taps into 32-bit accumulators
+ * @src: a pointer to the source byte of the first output byte
+ * @offs: the offset of every tap, in bytes, relative to the output byte
+ * @q: the fixed-point weight of every tap
+ * @ntaps: the number of taps, an even number
+ * @shift: the number of fractional bits of the weights
+ * @n: the number of output bytes
+ * @dst: receives the output bytes, clamped to [0, 255]
+ * Return: the number of output bytes processed, a multiple of 8
+ */
+
+__attribute__((target("sse4.1")))
+size_t fixed_span_sse41(uint8_t const *src, long const *offs,
+			int16_t const *q, size_t ntaps, int shift, size_t n,
+			uint8_t *dst)
+{
+	__m128i rnd = _mm_set1_epi32(1 << (shift - 1));
+	__m128i lo, hi, a, b, w, sh = _mm_cvtsi32_si128(shift);
+	size_t i, t;
+
+	for (i = 0; i + 8 <= n; i += 8)
+	{
+		lo = hi = rnd;
+		for (t = 0; t + 1 < ntaps; t += 2)
+		{
+			a = _mm_cvtepu8_epi16(LOAD64(src + i + offs[t]));
+			b = _mm_cvtepu8_epi16(LOAD64(src + i + offs[t + 1]));
+			w = _mm_set1_epi32(PAIR(q, t));
+			lo = MADD128(lo, _mm_unpacklo_epi16(a, b), w);
+			hi = MADD128(hi, _mm_unpackhi_epi16(a, b), w);
+		}
+		lo = _mm_packs_epi32(_mm_sra_epi32(lo, sh),
+				     _mm_sra_epi32(hi, sh));
+		lo = _mm_packus_epi16(lo, lo);
+		_mm_storel_epi64((__m128i *)(dst + i), lo);
+	}
+	return (i);
+}
+
+/**
+ * fixed_span_avx2 - program that convolves a span of bytes with pairs of
+ * fixed-point taps, 16 output bytes per iteration with AVX2
+ * @src: a pointer to the source byte of the first output byte
+ * @offs: the offset of every tap, in bytes, relative to the output byte
+ * @q: the fixed-point weight of every tap
+ * @ntaps: the number of taps, an even number
+ * @shift: the number of fractional bits of the weights
+ * @n: the number of output bytes
+ * @dst: receives the output bytes, clamped to [0, 255]
+ * Return: the number of output bytes processed, a multiple of 16
+ */
+
+__attribute__((target("avx2")))
+size_t fixed_span_avx2(uint8_t const *src, long const *offs,
+		       int16_t const *q, size_t ntaps, int shift, size_t n,
+		       uint8_t *dst)
+{
+	__m256i rnd = _mm256_set1_epi32(1 << (shift - 1));
+	__m256i lo, hi, a, b, w;
+	__m128i sh = _mm_cvtsi32_si128(shift);
+	size_t i, t;
+
+	for (i = 0; i + 16 <= n; i += 16)
+	{
+		lo = hi = rnd;
+		for (t = 0; t + 1 < ntaps; t += 2)
+		{
+			a = U8_EPI16(src + i + offs[t]);
+			b = U8_EPI16(src + i + offs[t + 1]);
+			w = _mm256_set1_epi32(PAIR(q, t));
+			lo = MADD256(lo, _mm256_unpacklo_epi16(a, b), w);
+			hi = MADD256(hi, _mm256_unpackhi_epi16(a, b), w);
+		}
+		lo = _mm256_packs_epi32(_mm256_sra_epi32(lo, sh),
+					_mm256_sra_epi32(hi, sh));
+		lo = _mm256_packus_epi16(lo, lo);
+		lo = _mm256_permute4x64_epi64(lo, 0x08);
+		_mm_storeu_si128((__m128i *)(dst + i),
+				 _mm256_castsi256_si128(lo));
+	}
+	return (i);
+}
+
+#else
+
+typedef int blur_fixed_x86_unused_t;
+
+#endif /* __x86_64__ || __i386__ */
@@ -0,0 +1,159 @@
+#include "blur_format.h"
+
+#define FORMAT_INLINE static inline __attribute__((always_inline))
+#define CLAMP_SAMPLE(v, max) ((v) <= 0 ? 0 : (v) >= (max) ? (max) : (v))
+#define SAMPLE(p, i, fmt) ((fmt) == PIXEL_RGBF ? ((float const *)(p))[i] : \
+	(fmt) == PIXEL_RGB16 ? (float)((uint16_t const *)(p))[i] : \
+	(float)((uint8_t const *)(p))[i])
+#define STORE(p, i, v, fmt) ((fmt) == PIXEL_RGBF ? \
+	(void)(((float *)(p))[i] = (v)) : (fmt) == PIXEL_RGB16 ? \
+	(void)(((uint16_t *)(p))[i] = CLAMP_SAMPLE(v, 65535)) : \
+	(void)(((uint8_t *)(p))[i] = CLAMP_SAMPLE(v, 255)))
+
+/**
+ * format_checked - program that accumulates the taps of one output pixel
+ * close to the borders of the image
+ * every tap is checked against the image bounds; with EDGE_RENORMALIZE
+ * the taps falling outside of the image are left out of both the weighted
+ * sum and the total weight, the other modes read them through edge_index
+ * @job: a pointer to the job
+ * @x: the column of the output pixel
+ * @y: the row of the output pixel
+ * @fmt: the pixel format, a constant of the caller
+ * @nch: the number of samples per pixel, a constant of the caller
+ * @acc: receives the weighted sum of every sample
+ * Return: the total weight of the taps read
+ */
+
+FORMAT_INLINE float format_checked(format_job_t const *job, size_t x,
+				   size_t y, pixel_format_t fmt, size_t nch,
+				   float *acc)
+{
+	ckernel_t const *ck = job->ck;
+	size_t w = job->img->w, h = job->img->h, i, c, p;
+	long px, py;
+	float sum = 0;
+
+	for (c = 0; c < nch; c++)
+		acc[c] = 0;
+	for (i = 0; i < ck->ntaps; i++)
+	{
+		px = (long)x + ck->tap_x[i], py = (long)y + ck->tap_y[i];
+		if (job->edge == EDGE_RENORMALIZE &&
+		    (px < 0 || px >= (long)w || py < 0 || py >= (long)h))
+			continue;
+		p = (edge_index(py, h, job->edge) * w +
+		     edge_index(px, w, job->edge)) * nch;
+		for (c = 0; c < nch; c++)
+			acc[c] += SAMPLE(job->img->pixels, p + c, fmt) *
+				ck->tap_w[i];
+		sum += ck->tap_w[i];
+	}
+	return (sum);
+}
+
+/**
+ * format_row - program that blurs a run of pixels of a row in one pixel
+ * format
+ * the pixels whose taps all fall inside the image are accumulated one tap
+ * at a time over the whole run, their samples being contiguous, then
+ * divided by the sum of the kernel, or by 1 if it is zero; the others go
+ * through format_checked; the function is inlined into one specialized
+ * row program per format, so the format costs no branch at run time
+ * @job: a pointer to the job
+ * @y: the row of the pixels
+ * @from: the first column to blur
+ * @to: the column past the last column to blur
+ * @acc: a buffer of (to - from) * nch floats
+ * @fmt: the pixel format, a constant of the caller
+ * @nch: the number of samples per pixel, a constant of the caller
+ * Return: nothing (void)
+ */
+
+FORMAT_INLINE void format_row(format_job_t const *job, size_t y, size_t from,
+			      size_t to, float *acc, pixel_format_t fmt,
+			      size_t nch)
+{
+	ckernel_t const *ck = job->ck;
+	size_t r = ck->size / 2, t = ck->size - 1 - r, w = job->img->w;
+	size_t xa = to, xb = to, x, i, c, k, n, p;
+	float v[4], sum;
+
+	if (y >= r && y + t < job->img->h && w > t)
+	{
+		xa = from > r ? from : r;
+		xb = w - t < to ? w - t : to;
+		xa = xa < xb ? xa : (xb = to);
+	}
+	for (x = from; x < to; x++)
+	{
+		if (x >= xa && x < xb)
+			continue;
+		sum = format_checked(job, x, y, fmt, nch, v);
+		sum = sum != 0 ? sum : 1;
+		for (c = 0; c < nch; c++)
+			STORE(job->img_blur->pixels, (y * w + x) * nch + c,
+			      v[c] / sum, fmt);
+	}
+	n = (xb - xa) * nch, p = (y * w + xa) * nch;
+	for (k = 0; k < n; k++)
+		acc[k] = 0;
+	for (i = 0; i < ck->ntaps; i++)
+		for (k = 0; k < n; k++)
+			acc[k] += SAMPLE(job->img->pixels, p + job->offs[i] + k,
+					 fmt) * ck->tap_w[i];
+	sum = ck->sum != 0 ? ck->sum : 1;
+	for (k = 0; k < n; k++)
+		STORE(job->img_blur->pixels, p + k, acc[k] / sum, fmt);
+}
+
+/**
+ * blur_row_rgba8 - program that blurs a run of pixels of a row of a
+ * PIXEL_RGBA8 image, see format_row
+ * @job: a pointer to the job
+ * @y: the row of the pixels
+ * @from: the first column to blur
+ * @to: the column past the last column to blur
+ * @acc: a buffer of (to - from) * 4 floats
+ * Return: nothing (void)
+ */
+
+void blur_row_rgba8(format_job_t const *job, size_t y, size_t from, size_t to,
+		    float *acc)
+{
+	format_row(job, y, from, to, acc, PIXEL_RGBA8, 4);
+}
+
+/**
+ * blur_row_rgb16 - program that blurs a run of pixels of a row of a
+ * PIXEL_RGB16 image, see format_row
+ * @job: a pointer to the job
+ * @y: the row of the pixels
+ * @from: the first column to blur
+ * @to: the column past the last column to blur
+ * @acc: a buffer of (to - from) * 4 floats
+ * Return: nothing (void)
+ */
+
+void blur_row_rgb16(format_job_t const *job, size_t y, size_t from, size_t to,
+		    float *acc)
+{
+	format_row(job, y, from, to, acc, PIXEL_RGB16, 3);
+}
+
+/**
+ * blur_row_rgbf - program that blurs a run of pixels of a row of a
+ * PIXEL_RGBF image, see format_row
+ * @job: a pointer to the job
+ * @y: the row of the pixels
+ * @from: the first column to blur
+ * @to: the column past the last column to blur
+ * @acc: a buffer of (to - from) * 4 floats
+ * Return: nothing (void)
+ */
+
+void blur_row_rgbf(format_job_t const *job, size_t y, size_t from, size_t to,
+		   float *acc)
+{
+	format_row(job, y, from, to, acc, PIXEL_RGBF, 3);
+}
@@ -0,0 +1,40 @@
+#ifndef BLUR_FORMAT_H
+#define BLUR_FORMAT_H
+
+#include "multithreading.h"
+
+/**
+ * struct format_job_s - Argument of the pool jobs of blur_image_format
+ * @img:      Source image
+ * @img_blur: Destination image, of the same size and format
+ * @tiles:    Tiles of the image, only their rectangles are used
+ * @ck:       Compiled kernel
+ * @offs:     Offset of every tap, in samples, relative to the output
+ *            pixel, for the pixels whose taps all fall inside the image
+ * @edge:     Edge mode
+ * @failed:   Set by a job that could not allocate its accumulators
+ */
+
+typedef struct format_job_s
+{
+    fimg_t const *img;
+    fimg_t *img_blur;
+    blur_portion_t const *tiles;
+    ckernel_t const *ck;
+    long *offs;
+    edge_mode_t edge;
+    int failed;
+} format_job_t;
+
+typedef void (*format_row_t)(format_job_t const *job, size_t y, size_t from,
+			     size_t to, float *acc);
+
+/* row programs - blur_format.c */
+void blur_row_rgba8(format_job_t const *job, size_t y, size_t from,
+		    size_t to, float *acc);
+void blur_row_rgb16(format_job_t const *job, size_t y, size_t from,
+		    size_t to, float *acc);
+void blur_row_rgbf(format_job_t const *job, size_t y, size_t from,
+		   size_t to, float *acc);
+
+#endif /* BLUR_FORMAT_H */
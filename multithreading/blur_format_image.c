@@ -0,0 +1,116 @@
+#include "blur_format.h"
+
+static format_row_t const format_rows[] = {
+	NULL, blur_row_rgba8, blur_row_rgb16, blur_row_rgbf
+};
+
+/**
+ * pixel_format_size - program that gives the size of a pixel of a format
+ * @format: the pixel format
+ * Return: the size of a pixel, in bytes
+ */
+
+size_t pixel_format_size(pixel_format_t format)
+{
+	switch (format)
+	{
+	case PIXEL_RGBA8:
+		return (4);
+	case PIXEL_RGB16:
+		return (3 * sizeof(uint16_t));
+	case PIXEL_RGBF:
+		return (3 * sizeof(float));
+	default:
+		return (sizeof(pixel_t));
+	}
+}
+
+/**
+ * format_tile - pool job program that blurs one tile of an image of any
+ * pixel format but PIXEL_RGB8, row by row with the row program of the
+ * format, through an accumulator row of its own; a job that cannot
+ * allocate it marks the blur as failed, its tile being left unwritten
+ * @arg: a pointer to the format_job_t describing the job
+ * @i: the index of the tile to blur
+ * Return: nothing (void)
+ */
+
+static void format_tile(void *arg, size_t i)
+{
+	format_job_t *job = arg;
+	blur_portion_t const *tile = job->tiles + i;
+	format_row_t row = format_rows[job->img->format];
+	float *acc = malloc(sizeof(float) * 4 * tile->w);
+	size_t y;
+
+	if (!acc)
+	{
+		fprintf(stderr, "blur_image_format: out of memory\n");
+		__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	for (y = tile->y; y < tile->y + tile->h; y++)
+		row(job, y, tile->x, tile->x + tile->w, acc);
+	free(acc);
+}
+
+/**
+ * blur_image_format - program that blurs an entire image of any pixel
+ * format
+ * PIXEL_RGB8 images go through blur_image_opts and give the same results;
+ * the other formats are cut into the tiles of blur_image_opts and blurred
+ * on the blur pool by the row program compiled for their format, with
+ * float accumulators; the 8 and 16-bit samples are clamped to their range
+ * and truncated, the float samples are stored as they are; opts->planar
+ * and opts->fixed apply to PIXEL_RGB8 only
+ * @img_blur: a pointer to the output image, of the size and format of img;
+ *            nothing is written to it otherwise
+ * @img: a pointer to the input image
+ * @kernel: a pointer to the convolution kernel
+ * @opts: a pointer to the blur options, NULL for the defaults
+ * Return: 1 on success, 0 on failure
+ */
+
+int blur_image_format(fimg_t *img_blur, fimg_t const *img,
+		      kernel_t const *kernel, blur_opts_t const *opts)
+{
+	blur_opts_t defaults = {EDGE_RENORMALIZE, 0, 0, 0, 0};
+	img_t src = {0, 0, NULL}, dst;
+	format_job_t job;
+	ckernel_t *ck;
+	size_t count = 0, i, nch = img->format == PIXEL_RGBA8 ? 4 : 3;
+	int ok;
+
+	opts = opts ? opts : &defaults;
+	src.w = img->w, src.h = img->h, src.pixels = img->pixels;
+	dst = src, dst.pixels = img_blur->pixels;
+	if (img_blur->format != img->format || img_blur->w != img->w ||
+	    img_blur->h != img->h || (unsigned int)img->format > PIXEL_RGBF)
+	{
+		fprintf(stderr, "blur_image_format: invalid or mismatched images\n");
+		return (0);
+	}
+	if (img->format == PIXEL_RGB8 || !img->w || !img->h)
+	{
+		if (img->format == PIXEL_RGB8)
+			blur_image_opts(&dst, &src, kernel, opts);
+		return (1);
+	}
+	job.img = img, job.img_blur = img_blur, job.edge = opts->edge;
+	job.ck = ck = kernel_compile(kernel), job.failed = 0;
+	job.tiles = portionTiles(&dst, &src, kernel, opts, &count);
+	job.offs = job.ck ? malloc(sizeof(long) * (job.ck->ntaps + 1)) : NULL;
+	for (i = 0; job.offs && i < job.ck->ntaps; i++)
+		job.offs[i] = (job.ck->tap_y[i] * (long)img->w +
+			       job.ck->tap_x[i]) * (long)nch;
+	ok = job.ck && job.tiles && job.offs;
+	if (ok)
+		blur_pool_run(count, format_tile, &job);
+	else
+		fprintf(stderr, "blur_image_format: cannot blur the image\n");
+	ok = ok && !job.failed;
+	free(job.offs);
+	free((void *)job.tiles);
+	kernel_free(ck);
+	return (ok);
+}
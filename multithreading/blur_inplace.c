@@ -0,0 +1,195 @@
+#include "multithreading.h"
+
+#include <string.h>
+
+#define INPLACE_CHUNK 16
+
+/**
+ * struct inplace_job_s - Argument of the pool jobs of an in-place blur
+ * @img:    the image, blurred in place
+ * @ck:     the compiled kernel
+ * @opts:   the blur options
+ * @nbands: the number of bands, one per job
+ * @chunk:  the number of rows blurred per step of a band
+ * @halo:   the kernel_size - 1 source rows around every band, saved before
+ *          any band is overwritten
+ * @work:   the rolling window and output rows of every band
+ */
+
+typedef struct inplace_job_s
+{
+	img_t *img;
+	ckernel_t *ck;
+	blur_opts_t const *opts;
+	size_t nbands;
+	size_t chunk;
+	pixel_t *halo;
+	pixel_t *work;
+} inplace_job_t;
+
+/**
+ * inplace_row - program that finds the source of a row needed by a band
+ * rows of the band are still intact in the image when they are needed,
+ * rows around it come from the halo saved for the band
+ * @job: a pointer to the job
+ * @band: the index of the band
+ * @v: the row, inside the band or its halo
+ * Return: a pointer to the first pixel of the row
+ */
+
+static pixel_t const *inplace_row(inplace_job_t const *job, size_t band,
+				  long v)
+{
+	long y0 = band * job->img->h / job->nbands, r = job->ck->size / 2;
+	long y1 = (band + 1) * job->img->h / job->nbands;
+	size_t w = job->img->w;
+	pixel_t const *halo = job->halo + band * (job->ck->size - 1) * w;
+
+	if (v >= y0 && v < y1)
+		return (job->img->pixels + v * w);
+	return (halo + (v < y0 ? v - (y0 - r) : r + v - y1) * w);
+}
+
+/**
+ * inplace_halo - program that saves the kernel_size - 1 source rows
+ * around a band, the rows above it first, fetched through the edge mode
+ * (and skipped outside of the image with EDGE_RENORMALIZE)
+ * @job: a pointer to the job
+ * @band: the index of the band
+ * Return: nothing (void)
+ */
+
+static void inplace_halo(inplace_job_t const *job, size_t band)
+{
+	long y0 = band * job->img->h / job->nbands, r = job->ck->size / 2;
+	long y1 = (band + 1) * job->img->h / job->nbands, i, v;
+	long keep = job->ck->size - 1, h = job->img->h;
+	size_t w = job->img->w;
+
+	for (i = 0; i < keep; i++)
+	{
+		v = i < r ? y0 - r + i : y1 + i - r;
+		if (job->opts->edge == EDGE_RENORMALIZE && (v < 0 || v >= h))
+			continue;
+		memcpy(job->halo + (band * keep + i) * w, job->img->pixels +
+		       edge_index(v, h, job->opts->edge) * w,
+		       sizeof(pixel_t) * w);
+	}
+}
+
+/**
+ * inplace_chunk - program that blurs one chunk of rows of a band
+ * the window of source rows of the chunk is completed with the rows below
+ * it, the rows above it being left by the previous chunk, then the chunk
+ * is blurred into the output rows of the band and copied over the image
+ * @job: a pointer to the job
+ * @band: the index of the band
+ * @c0: the first row of the chunk
+ * @c1: the row past the last row of the chunk
+ * @from: the first row missing from the window
+ * Return: nothing (void)
+ */
+
+static void inplace_chunk(inplace_job_t const *job, size_t band, long c0,
+			  long c1, long from)
+{
+	long r = job->ck->size / 2, t = job->ck->size - 1 - r, h = job->img->h;
+	long v, lo = c0 - r, hi = c1 + t, rows = job->chunk + job->ck->size - 1;
+	size_t w = job->img->w;
+	pixel_t *win = job->work + band * (rows + job->chunk) * w;
+	blur_portion_t p;
+	img_t src, dst;
+
+	if (job->opts->edge == EDGE_RENORMALIZE)
+		lo = lo < 0 ? 0 : lo, hi = hi > h ? h : hi;
+	for (v = from < lo ? lo : from; v < hi; v++)
+		memcpy(win + (v - (c0 - r)) * w, inplace_row(job, band, v),
+		       sizeof(pixel_t) * w);
+	src.w = dst.w = w, src.h = dst.h = hi - lo;
+	src.pixels = win + (lo - (c0 - r)) * w;
+	dst.pixels = win + (rows - (c0 - lo)) * w;
+	p.img = &src, p.img_blur = &dst, p.x = 0, p.y = c0 - lo;
+	p.w = w, p.h = c1 - c0, p.kernel = &job->ck->kernel;
+	p.edge = job->opts->edge;
+	if (job->opts->fixed)
+		blur_portion_fixed(&p, job->ck, p.edge);
+	else
+		blur_portion_ck_edge(&p, job->ck, p.edge);
+	memcpy(job->img->pixels + c0 * w, win + rows * w,
+	       sizeof(pixel_t) * w * (c1 - c0));
+}
+
+/**
+ * inplace_job - pool job program that blurs one band of an image in place
+ * the band is walked top to bottom in chunks; before a chunk is written
+ * over the image the window slides down, keeping the kernel_size - 1
+ * source rows the next chunk shares with it
+ * @arg: a pointer to the inplace_job_t describing the blur
+ * @band: the index of the band
+ * Return: nothing (void)
+ */
+
+static void inplace_job(void *arg, size_t band)
+{
+	inplace_job_t const *job = arg;
+	long y0 = band * job->img->h / job->nbands, r = job->ck->size / 2;
+	long y1 = (band + 1) * job->img->h / job->nbands, c0, c1;
+	long keep = job->ck->size - 1, t = keep - r;
+	size_t w = job->img->w;
+	pixel_t *win = job->work + band * (2 * job->chunk + keep) * w;
+
+	for (c0 = y0; c0 < y1; c0 = c1)
+	{
+		c1 = c0 + (long)job->chunk < y1 ? c0 + (long)job->chunk : y1;
+		if (c0 != y0)
+			memmove(win, win + job->chunk * w,
+				sizeof(pixel_t) * w * keep);
+		inplace_chunk(job, band, c0, c1, c0 == y0 ? y0 - r : c0 + t);
+	}
+}
+
+/**
+ * blur_image_inplace - program that blurs an entire image in place, with
+ * a few rows of extra memory per thread instead of a second image
+ * the image is cut into one band of rows per worker of the blur pool;
+ * the kernel_size - 1 source rows around every band are saved before any
+ * band is overwritten, then every band is blurred by its own worker
+ * through a rolling window of source rows; opts->planar is ignored
+ * @img: a pointer to the image data structure, blurred in place
+ * @kernel: a pointer to the convolution kernel
+ * @opts: a pointer to the blur options, NULL for the defaults
+ * Return: 1 on success, 0 on failure
+ */
+
+int blur_image_inplace(img_t *img, kernel_t const *kernel,
+		       blur_opts_t const *opts)
+{
+	blur_opts_t defaults = {EDGE_RENORMALIZE, 0, 0, 0, 0};
+	inplace_job_t job;
+	size_t b, keep;
+
+	if (!img || !kernel || !img->pixels)
+		return (0);
+	if (!img->w || !img->h)
+		return (1);
+	job.img = img, job.opts = opts ? opts : &defaults;
+	job.ck = kernel_compile(kernel);
+	job.nbands = blur_pool_size() < img->h ? blur_pool_size() : img->h;
+	keep = kernel->size - 1;
+	job.chunk = kernel->size > INPLACE_CHUNK ? kernel->size : INPLACE_CHUNK;
+	job.halo = job.ck ? malloc(sizeof(pixel_t) * img->w * job.nbands *
+				   (2 * keep + 2 * job.chunk)) : NULL;
+	if (!job.halo)
+	{
+		kernel_free(job.ck);
+		fprintf(stderr, "blur_image_inplace: out of memory\n");
+		return (0);
+	}
+	job.work = job.halo + job.nbands * keep * img->w;
+	for (b = 0; b < job.nbands; b++)
+		inplace_halo(&job, b);
+	blur_pool_run(job.nbands, inplace_job, &job);
+	free(job.halo);
+	kernel_free(job.ck);
+	return (1);
+}
@@ -0,0 +1,165 @@
+#include "multithreading.h"
+
+#define SEPARABLE_EPSILON 1e-5f
+#define ABSF(v) ((v) < 0 ? -(v) : (v))
+#define CKERNEL_ALIGN 64
+
+/**
+ * kernel_separate - program that factors a square convolution kernel into
+ * a column vector and a row vector whose outer product is the kernel
+ * the largest coefficient is used as the pivot so that the factors stay
+ * well conditioned; the kernel is considered separable when every
+ * coefficient matches the outer product within a relative tolerance
+ * @kernel: a pointer to the convolution kernel to factor
+ * @row: a buffer of kernel->size floats receiving the horizontal factor
+ * @col: a buffer of kernel->size floats receiving the vertical factor
+ * Return: 1 if the kernel is separable, 0 otherwise
+ */
+
+int kernel_separate(kernel_t const *kernel, float *row, float *col)
+{
+	size_t i, j, pi = 0, pj = 0;
+	float max = 0, v;
+
+	if (!kernel || !kernel->matrix || !kernel->size || !row || !col)
+		return (0);
+	for (i = 0; i < kernel->size; i++)
+		for (j = 0; j < kernel->size; j++)
+		{
+			v = ABSF(kernel->matrix[i][j]);
+			if (v > max)
+				max = v, pi = i, pj = j;
+		}
+	if (max == 0)
+		return (0);
+	for (i = 0; i < kernel->size; i++)
+	{
+		row[i] = kernel->matrix[pi][i];
+		col[i] = kernel->matrix[i][pj] / kernel->matrix[pi][pj];
+	}
+	for (i = 0; i < kernel->size; i++)
+		for (j = 0; j < kernel->size; j++)
+		{
+			v = kernel->matrix[i][j] - col[i] * row[j];
+			if (ABSF(v) > max * SEPARABLE_EPSILON)
+				return (0);
+		}
+	return (1);
+}
+
+/**
+ * kernel_symmetry - program that detects the symmetries of a kernel
+ * @w: the weights of the kernel, row-major
+ * @size: the size of the kernel
+ * Return: a combination of the KERNEL_SYM_* flags
+ */
+
+static int kernel_symmetry(float const *w, size_t size)
+{
+	int sym = KERNEL_SYM_H | KERNEL_SYM_V | KERNEL_SYM_D;
+	size_t i, j;
+
+	for (i = 0; i < size; i++)
+		for (j = 0; j < size; j++)
+		{
+			if (w[i * size + j] != w[i * size + size - 1 - j])
+				sym &= ~KERNEL_SYM_H;
+			if (w[i * size + j] != w[(size - 1 - i) * size + j])
+				sym &= ~KERNEL_SYM_V;
+			if (w[i * size + j] != w[j * size + i])
+				sym &= ~KERNEL_SYM_D;
+		}
+	return (sym);
+}
+
+/**
+ * kernel_layout - program that carves the arrays of a compiled kernel out
+ * of its single aligned block
+ * the weights come first so that they start on the alignment boundary
+ * @ck: a pointer to the compiled kernel, whose size is already set
+ * @block: the aligned block, as sized by kernel_compile
+ * Return: nothing (void)
+ */
+
+static void kernel_layout(ckernel_t *ck, void *block)
+{
+	size_t n = ck->size * ck->size, i;
+
+	ck->weights = block;
+	ck->row = ck->weights + n;
+	ck->col = ck->row + ck->size;
+	ck->kernel.size = ck->size;
+	ck->tap_w = ck->col + ck->size;
+	ck->kernel.matrix = (float **)(ck->tap_w + n);
+	ck->tap_x = (long *)(ck->kernel.matrix + ck->size);
+	ck->tap_y = ck->tap_x + n;
+	ck->tap_q = (int16_t *)(ck->tap_y + n);
+	for (i = 0; i < ck->size; i++)
+		ck->kernel.matrix[i] = ck->weights + i * ck->size;
+}
+
+/**
+ * kernel_compile - program that compiles a convolution kernel into a
+ * representation the blur can use without chasing pointers
+ * the weights are copied into one aligned contiguous array, and their sum,
+ * separable factors, symmetries and non-zero taps, in floating and fixed
+ * point, are precomputed once;
+ * the compiled kernel also exposes a kernel_t view of its own weights
+ * @kernel: a pointer to the convolution kernel to compile
+ * Return: a pointer to the compiled kernel, to be released with
+ *         kernel_free, or NULL on failure
+ */
+
+ckernel_t *kernel_compile(kernel_t const *kernel)
+{
+	ckernel_t *ck;
+	void *block = NULL;
+	size_t i, n, bytes;
+	long r;
+
+	if (!kernel || !kernel->matrix || !kernel->size)
+		return (NULL);
+	ck = malloc(sizeof(*ck));
+	n = kernel->size * kernel->size;
+	bytes = sizeof(float) * (2 * n + 2 * kernel->size) +
+		sizeof(float *) * kernel->size + sizeof(long) * 2 * n +
+		sizeof(int16_t) * n;
+	if (!ck || posix_memalign(&block, CKERNEL_ALIGN, bytes))
+	{
+		free(ck);
+		return (NULL);
+	}
+	ck->size = kernel->size;
+	r = (long)ck->size / 2;
+	kernel_layout(ck, block);
+	for (i = 0, ck->sum = 0, ck->ntaps = 0; i < n; i++)
+	{
+		ck->weights[i] = kernel->matrix[i / ck->size][i % ck->size];
+		ck->sum += ck->weights[i];
+		if (ck->weights[i] == 0)
+			continue;
+		ck->tap_x[ck->ntaps] = (long)(i % ck->size) - r;
+		ck->tap_y[ck->ntaps] = (long)(i / ck->size) - r;
+		ck->tap_w[ck->ntaps++] = ck->weights[i];
+	}
+	ck->separable = kernel_separate(kernel, ck->row, ck->col);
+	ck->sym = kernel_symmetry(ck->weights, ck->size);
+	kernel_quantize(ck);
+	ck->fft = NULL;
+	return (ck);
+}
+
+/**
+ * kernel_free - program that releases a compiled kernel
+ * @ck: a pointer to the compiled kernel, may be NULL
+ * Return: nothing (void)
+ */
+
+void kernel_free(ckernel_t *ck)
+{
+	if (!ck)
+		return;
+	fft_free(ck->fft);
+	free(ck->weights);
+	free(ck);
+}
@@ -0,0 +1,86 @@
+#include "multithreading.h"
+
+#include <string.h>
+
+static pthread_key_t kernel_key;
+static int kernel_key_ok;
+
+/**
+ * kernel_cache_free - thread-specific data destructor program that
+ * releases the compiled kernel cached by an exiting thread
+ * @ck: a pointer to the compiled kernel
+ * Return: nothing (void)
+ */
+
+static void kernel_cache_free(void *ck)
+{
+	kernel_free(ck);
+}
+
+/**
+ * kernel_cache_init - program that creates the thread-specific key of the
+ * compiled kernel cache
+ * this function is marked with the constructor attribute, so the key is
+ * created once at startup; without it kernel_cached fails
+ * Return: nothing (void)
+ */
+
+__attribute__((constructor))
+static void kernel_cache_init(void)
+{
+	kernel_key_ok = !pthread_key_create(&kernel_key, kernel_cache_free);
+}
+
+/**
+ * kernel_matches - program that checks whether a compiled kernel was
+ * compiled from the weights a kernel holds now
+ * @ck: a pointer to the compiled kernel
+ * @kernel: a pointer to the convolution kernel
+ * Return: 1 if the sizes and every weight are the same, 0 otherwise
+ */
+
+static int kernel_matches(ckernel_t const *ck, kernel_t const *kernel)
+{
+	size_t i;
+
+	if (ck->size != kernel->size)
+		return (0);
+	for (i = 0; i < ck->size; i++)
+		if (memcmp(ck->kernel.matrix[i], kernel->matrix[i],
+			   sizeof(float) * ck->size))
+			return (0);
+	return (1);
+}
+
+/**
+ * kernel_cached - program that gives the compiled form of a kernel,
+ * compiling it only if the calling thread did not compile the same
+ * weights last
+ * every thread keeps the last kernel it compiled, released when the
+ * thread exits, so the portion programs called again and again with the
+ * same kernel (see blur_portion and blur_portion_edge) compile it once per
+ * thread; the weights are compared rather than the pointer, so a kernel
+ * changed in place between two calls is compiled again
+ * @kernel: a pointer to the convolution kernel
+ * Return: a pointer to the compiled kernel, valid until the next call of
+ *         the calling thread and not to be released, or NULL on failure
+ */
+
+ckernel_t const *kernel_cached(kernel_t const *kernel)
+{
+	ckernel_t *ck;
+
+	if (!kernel_key_ok || !kernel || !kernel->matrix || !kernel->size)
+		return (NULL);
+	ck = pthread_getspecific(kernel_key);
+	if (ck && kernel_matches(ck, kernel))
+		return (ck);
+	kernel_free(ck);
+	ck = kernel_compile(kernel);
+	if (pthread_setspecific(kernel_key, ck))
+	{
+		kernel_free(ck);
+		return (NULL);
+	}
+	return (ck);
+}
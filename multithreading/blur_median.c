@@ -0,0 +1,249 @@
+#include "multithreading.h"
+
+#include <string.h>
+
+#define MEDIAN_MAX_RADIUS 127
+#define MEDIAN_TILE_W 128
+#define RUN(m, j, ch, b) ((m)->cols[j].fine[ch] + (b) * 16)
+
+/**
+ * struct median_hist_s - Histograms of the three channels of a set of
+ * pixels, at full and at 1/16 resolution
+ * @fine:   count of every value of every channel
+ * @coarse: count of every run of 16 values of every channel
+ * @n:      number of pixels
+ */
+
+typedef struct median_hist_s
+{
+	uint16_t fine[3][256];
+	uint16_t coarse[3][16];
+	uint16_t n;
+} median_hist_t;
+
+/**
+ * struct median_s - State of the median filter of a tile
+ * @img:  the source image
+ * @edge: the edge mode
+ * @r:    the radius of the footprint
+ * @cols: the histogram of every column of the footprint of the tile, over
+ *        the rows of the footprint of the current output row
+ * @xmap: the source column of every column histogram, -1 if it is out of
+ *        the image and dropped
+ * @k:    the histogram of the footprint of the current output pixel; its
+ *        coarse counts are always up to date, its runs of 16 fine counts
+ *        only as of @sync
+ * @sync: one plus the output pixel the fine counts of every run of @k
+ *        were last brought up to date for, 0 for never
+ */
+
+typedef struct median_s
+{
+	img_t const *img;
+	edge_mode_t edge;
+	size_t r;
+	median_hist_t *cols;
+	long *xmap;
+	median_hist_t k;
+	size_t sync[3][16];
+} median_t;
+
+/**
+ * median_row - program that adds a row of the image to every column
+ * histogram, or removes it
+ * rows out of the image are read through the edge mode, or dropped with
+ * EDGE_RENORMALIZE
+ * @m: a pointer to the state of the filter
+ * @tile: a pointer to the tile
+ * @ry: the row, possibly out of the image
+ * @sign: 1 to add, 0xffff to remove
+ * Return: nothing (void)
+ */
+
+static void median_row(median_t *m, blur_portion_t const *tile, long ry,
+		       uint16_t sign)
+{
+	size_t c, ch, w = m->img->w, h = m->img->h;
+	pixel_t const *row, *p;
+	median_hist_t *col;
+	uint8_t v[3];
+
+	if (m->edge == EDGE_RENORMALIZE && (ry < 0 || ry >= (long)h))
+		return;
+	row = m->img->pixels + edge_index(ry, h, m->edge) * w;
+	for (c = 0; c < tile->w + 2 * m->r; c++)
+	{
+		if (m->xmap[c] < 0)
+			continue;
+		p = row + m->xmap[c], col = m->cols + c;
+		v[0] = p->r, v[1] = p->g, v[2] = p->b;
+		for (ch = 0; ch < 3; ch++)
+		{
+			col->fine[ch][v[ch]] += sign;
+			col->coarse[ch][v[ch] >> 4] += sign;
+		}
+		col->n += sign;
+	}
+}
+
+/**
+ * median_coarse - program that adds the coarse counts of a column
+ * histogram to the histogram of the footprint, or subtracts them
+ * the counts wrap around modulo 2^16, so subtracting is adding the
+ * two's complement of 1 and the result is exact whenever the true counts
+ * fit in 16 bits
+ * @m: a pointer to the state of the filter
+ * @col: a pointer to the column histogram
+ * @sign: 1 to add, 0xffff to subtract
+ * Return: nothing (void)
+ */
+
+static void median_coarse(median_t *m, median_hist_t const *col,
+			  uint16_t sign)
+{
+	size_t ch, b;
+
+	for (ch = 0; ch < 3; ch++)
+		for (b = 0; b < 16; b++)
+			m->k.coarse[ch][b] += col->coarse[ch][b] * sign;
+	m->k.n += col->n * sign;
+}
+
+/**
+ * median_pick - program that finds the median of every channel of the
+ * footprint of an output pixel, the lower one for an even number of
+ * pixels
+ * the run of 16 values holding the median is found in the coarse counts;
+ * only the fine counts of that run are then brought up to date, by
+ * sliding them over the pixels passed since they last were, or by summing
+ * the footprint again if that is shorter; the median moving little from a
+ * pixel to the next, few fine counts are touched per pixel
+ * @m: a pointer to the state of the filter
+ * @x: the index of the output pixel in the tile, its footprint spanning
+ *     column histograms x to x + 2r
+ * @out: a pointer to the pixel receiving the medians
+ * Return: nothing (void)
+ */
+
+static void median_pick(median_t *m, size_t x, pixel_t *out)
+{
+	unsigned int target = (m->k.n + 1) / 2, sum, ch, b, i, v[3];
+	size_t j, d = 2 * m->r;
+	uint16_t *f;
+
+	for (ch = 0; ch < 3; ch++)
+	{
+		for (b = 0, sum = 0; sum + m->k.coarse[ch][b] < target; b++)
+			sum += m->k.coarse[ch][b];
+		f = m->k.fine[ch] + b * 16, j = m->sync[ch][b];
+		if (!j || x + 1 - j > d + 1)
+		{
+			memset(f, 0, sizeof(uint16_t) * 16);
+			for (j = x; j <= x + d; j++)
+				for (i = 0; i < 16; i++)
+					f[i] += RUN(m, j, ch, b)[i];
+		}
+		else
+			for (; j <= x; j++)
+				for (i = 0; i < 16; i++)
+					f[i] += RUN(m, j + d, ch, b)[i] -
+						RUN(m, j - 1, ch, b)[i];
+		m->sync[ch][b] = x + 1;
+		for (i = 0; sum + f[i] < target; i++)
+			sum += f[i];
+		v[ch] = b * 16 + i;
+	}
+	out->r = v[0], out->g = v[1], out->b = v[2];
+}
+
+/**
+ * median_tile - stencil program that runs a median filter over one tile
+ * of an image
+ * one histogram per column of the footprint of the tile is slid down the
+ * rows, one row in and one row out; along an output row the coarse
+ * counts of the footprint are slid right, one column histogram in and one
+ * out, and the fine counts as needed (see median_pick), so the cost per
+ * pixel does not depend on the radius
+ * @tile: a pointer to the tile, whose kernel size is the footprint size
+ * @ctx: unused
+ * Return: 1 on success, 0 if the histograms could not be allocated
+ */
+
+static int median_tile(blur_portion_t const *tile, void const *ctx)
+{
+	size_t c, x, y, ncols = tile->w + tile->kernel->size / 2 * 2;
+	long cx, r = (long)(tile->kernel->size / 2);
+	median_t *m = calloc(1, sizeof(median_t) + ncols *
+			     (sizeof(long) + sizeof(median_hist_t)));
+
+	(void)ctx;
+	if (!m)
+	{
+		fprintf(stderr, "blur_median: out of memory\n");
+		return (0);
+	}
+	m->img = tile->img, m->edge = tile->edge, m->r = (size_t)r;
+	m->xmap = (long *)(m + 1), m->cols = (median_hist_t *)(m->xmap + ncols);
+	for (c = 0; c < ncols; c++)
+	{
+		cx = (long)(tile->x + c) - r;
+		m->xmap[c] = m->edge == EDGE_RENORMALIZE &&
+			(cx < 0 || cx >= (long)m->img->w) ? -1 :
+			(long)edge_index(cx, m->img->w, m->edge);
+	}
+	for (cx = (long)tile->y - r; cx < (long)tile->y + r; cx++)
+		median_row(m, tile, cx, 1);
+	for (y = tile->y; y < tile->y + tile->h; y++)
+	{
+		median_row(m, tile, (long)y + r, 1);
+		memset(&m->k, 0, sizeof(m->k));
+		memset(m->sync, 0, sizeof(m->sync));
+		for (c = 0; c < 2 * m->r; c++)
+			median_coarse(m, m->cols + c, 1);
+		for (x = 0; x < tile->w; x++)
+		{
+			median_coarse(m, m->cols + x + 2 * m->r, 1);
+			median_pick(m, x, tile->img_blur->pixels +
+				    y * tile->img_blur->w + tile->x + x);
+			median_coarse(m, m->cols + x, 0xffff);
+		}
+		median_row(m, tile, (long)y - r, 0xffff);
+	}
+	free(m);
+	return (1);
+}
+
+/**
+ * blur_median - program that runs a median filter over an entire image
+ * using multithreading
+ * every output pixel takes, channel by channel, the median of the square
+ * footprint of 2 * radius + 1 pixels around it; the pixels of the
+ * footprint out of the image follow opts->edge, EDGE_RENORMALIZE taking
+ * the median of the pixels inside the image only; the tiles are
+ * MEDIAN_TILE_W wide unless opts sets their size
+ * @img_blur: a pointer to the output image data structure
+ * @img: a pointer to the input image data structure
+ * @radius: the radius of the footprint, at most MEDIAN_MAX_RADIUS
+ * @opts: a pointer to the blur options, NULL for the defaults; planar and
+ *        fixed are ignored
+ * Return: 1 on success, 0 on failure
+ */
+
+int blur_median(img_t *img_blur, img_t const *img, size_t radius,
+		blur_opts_t const *opts)
+{
+	blur_opts_t tiles = {EDGE_RENORMALIZE, 0, 0, 0, 0};
+	stencil_t st;
+
+	if (radius > MEDIAN_MAX_RADIUS)
+	{
+		fprintf(stderr, "blur_median: radius %lu above %d\n",
+			(unsigned long)radius, MEDIAN_MAX_RADIUS);
+		return (0);
+	}
+	tiles = opts ? *opts : tiles;
+	tiles.tile_w = tiles.tile_w ? tiles.tile_w : MEDIAN_TILE_W;
+	st.size = 2 * radius + 1, st.kernel = NULL;
+	st.portion = median_tile, st.ctx = NULL;
+	return (blur_stencil(img_blur, img, &st, &tiles));
+}
@@ -0,0 +1,236 @@
+#include "multithreading.h"
+
+#include <string.h>
+
+/**
+ * struct pipe_job_s - Argument of the pool jobs of a fused pipeline
+ * @img:      the source image
+ * @img_blur: the destination image
+ * @cks:      the compiled kernel of every stage
+ * @n:        the number of stages
+ * @opts:     the blur options
+ * @tw:       the width of the output tiles
+ * @th:       the height of the output tiles
+ * @scratch:  the number of pixels of each of the two scratch buffers
+ * @failed:   set by a job that could not allocate its scratch buffers
+ */
+
+typedef struct pipe_job_s
+{
+	img_t const *img;
+	img_t *img_blur;
+	ckernel_t **cks;
+	size_t n;
+	blur_opts_t const *opts;
+	size_t tw;
+	size_t th;
+	size_t scratch;
+	int failed;
+} pipe_job_t;
+
+/**
+ * pipe_region - program that finds the pixels a stage of the pipeline
+ * reads to produce an output tile
+ * the tile is grown by the reach of every stage from the given one on,
+ * size / 2 pixels to the left and top and size - 1 - size / 2 to the
+ * right and bottom, then clipped to the image
+ * @job: a pointer to the job
+ * @tile: the output tile
+ * @stage: the stage, job->n for the output tile itself
+ * @r: receives the region
+ * Return: nothing (void)
+ */
+
+static void pipe_region(pipe_job_t const *job, rect_t const *tile,
+			size_t stage, rect_t *r)
+{
+	size_t lo = 0, hi = 0, x1, y1;
+
+	for (; stage < job->n; stage++)
+	{
+		lo += job->cks[stage]->size / 2;
+		hi += job->cks[stage]->size - 1 - job->cks[stage]->size / 2;
+	}
+	r->x = tile->x > lo ? tile->x - lo : 0;
+	r->y = tile->y > lo ? tile->y - lo : 0;
+	x1 = tile->x + tile->w + hi, y1 = tile->y + tile->h + hi;
+	r->w = (x1 < job->img->w ? x1 : job->img->w) - r->x;
+	r->h = (y1 < job->img->h ? y1 : job->img->h) - r->y;
+}
+
+/**
+ * pipe_stage - program that runs one stage of the pipeline over a tile
+ * the stage blurs the part of its input region that the next stages
+ * need, then packs it at the start of the output buffer; the input region
+ * only ends where the image does, so the edge mode applies there exactly
+ * like it does on the whole intermediate image
+ * @job: a pointer to the job
+ * @stage: the index of the stage
+ * @in: the input region of the stage, whose pixels are packed in @src
+ * @out: the region the stage produces, within @in
+ * @src: the input buffer
+ * @dst: the output buffer, of job->scratch pixels
+ * Return: nothing (void)
+ */
+
+static void pipe_stage(pipe_job_t const *job, size_t stage, rect_t const *in,
+		       rect_t const *out, pixel_t *src, pixel_t *dst)
+{
+	img_t a, b;
+	blur_portion_t p;
+	size_t i;
+
+	a.w = b.w = in->w, a.h = b.h = in->h, a.pixels = src, b.pixels = dst;
+	p.img = &a, p.img_blur = &b;
+	p.x = out->x - in->x, p.y = out->y - in->y, p.w = out->w, p.h = out->h;
+	p.kernel = &job->cks[stage]->kernel, p.edge = job->opts->edge;
+	if (job->opts->fixed)
+		blur_portion_fixed(&p, job->cks[stage], p.edge);
+	else
+		blur_portion_ck_edge(&p, job->cks[stage], p.edge);
+	for (i = 0; i < out->h; i++)
+		memmove(dst + i * out->w, dst + (p.y + i) * in->w + p.x,
+			sizeof(pixel_t) * out->w);
+}
+
+/**
+ * pipe_job - pool job program that runs every stage of the pipeline over
+ * one row of output tiles
+ * the source region of a tile is copied into a scratch buffer, every
+ * stage then blurs from one scratch buffer into the other, the regions
+ * shrinking down to the tile, which is finally written to the output; the
+ * image is read and written once whatever the number of stages; a job
+ * that cannot allocate its scratch buffers marks the pipeline as failed
+ * @arg: a pointer to the pipe_job_t describing the pipeline
+ * @row: the index of the row of tiles
+ * Return: nothing (void)
+ */
+
+static void pipe_job(void *arg, size_t row)
+{
+	pipe_job_t *job = arg;
+	pixel_t *buf = malloc(sizeof(pixel_t) * 2 * job->scratch), *tmp;
+	pixel_t *src = buf, *dst = buf + job->scratch;
+	rect_t tile, in, out;
+	size_t s, i;
+
+	tile.y = row * job->th;
+	tile.h = job->img->h - tile.y;
+	tile.h = tile.h < job->th ? tile.h : job->th;
+	for (tile.x = 0; buf && tile.x < job->img->w; tile.x += job->tw)
+	{
+		tile.w = job->img->w - tile.x < job->tw ?
+			job->img->w - tile.x : job->tw;
+		pipe_region(job, &tile, 0, &in);
+		for (i = 0; i < in.h; i++)
+			memcpy(src + i * in.w, job->img->pixels + (in.y + i) *
+			       job->img->w + in.x, sizeof(pixel_t) * in.w);
+		for (s = 0; s < job->n; s++, in = out)
+		{
+			pipe_region(job, &tile, s + 1, &out);
+			pipe_stage(job, s, &in, &out, src, dst);
+			tmp = src, src = dst, dst = tmp;
+		}
+		for (i = 0; i < tile.h; i++)
+			memcpy(job->img_blur->pixels + (tile.y + i) *
+			       job->img->w + tile.x, src + i * tile.w,
+			       sizeof(pixel_t) * tile.w);
+	}
+	if (!buf)
+	{
+		fprintf(stderr, "blur_pipeline: out of memory\n");
+		__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+	}
+	free(buf);
+}
+
+/**
+ * pipe_sequential - program that runs the stages of a pipeline one after
+ * the other over the whole image, for EDGE_WRAP, whose halo may come
+ * from the far side of the image and thus from no tile region
+ * @img_blur: a pointer to the output image data structure
+ * @img: a pointer to the input image data structure
+ * @job: a pointer to the job, whose kernels are compiled
+ * Return: 1 on success, 0 on failure
+ */
+
+static int pipe_sequential(img_t *img_blur, img_t const *img,
+			   pipe_job_t const *job)
+{
+	img_t tmp, *dst;
+	img_t const *src = img;
+	size_t s;
+	int ok = 1;
+
+	tmp.w = img->w, tmp.h = img->h;
+	tmp.pixels = job->n > 1 ? malloc(sizeof(pixel_t) * img->w * img->h) :
+		NULL;
+	if (job->n > 1 && !tmp.pixels)
+		return (0);
+	if (!job->n)
+		memcpy(img_blur->pixels, img->pixels,
+		       sizeof(pixel_t) * img->w * img->h);
+	for (s = 0; ok && s < job->n; s++, src = dst)
+	{
+		dst = (job->n - 1 - s) % 2 ? &tmp : img_blur;
+		ok = blur_image_ck(dst, src, job->cks[s], job->opts);
+	}
+	free(tmp.pixels);
+	return (ok);
+}
+
+/**
+ * blur_pipeline - program that runs a chain of convolutions over an image
+ * in a single pass through memory
+ * the output is cut into tiles grown by the reach of every stage; each
+ * pool job carries a row of tiles through every stage in two scratch
+ * buffers, so the intermediate images never exist in full; the result
+ * is that of blurring the image with every kernel in turn, the
+ * intermediate images being rounded to 8 bits (bit for bit with fixed,
+ * within the one-level rounding the float paths show across tile sizes
+ * otherwise); with EDGE_WRAP the stages run in turn over the whole image
+ * @img_blur: a pointer to the output image data structure
+ * @img: a pointer to the input image data structure
+ * @kernels: the kernel of every stage, in order
+ * @nstages: the number of stages
+ * @opts: a pointer to the blur options, NULL for the defaults; planar is
+ *        ignored
+ * Return: 1 on success, 0 on failure
+ */
+
+int blur_pipeline(img_t *img_blur, img_t const *img,
+		  kernel_t const *const *kernels, size_t nstages,
+		  blur_opts_t const *opts)
+{
+	blur_opts_t defaults = {EDGE_RENORMALIZE, 0, 0, 0, 0};
+	size_t grow = 0, tw, th;
+	pipe_job_t job;
+	int ok = 1;
+
+	job.opts = opts ? opts : &defaults, job.img = img;
+	job.img_blur = img_blur;
+	job.cks = malloc(sizeof(ckernel_t *) * (nstages ? nstages : 1));
+	for (job.n = 0; job.cks && job.n < nstages; job.n++)
+	{
+		job.cks[job.n] = kernel_compile(kernels[job.n]);
+		if (!job.cks[job.n])
+			break;
+		grow += job.cks[job.n]->size - 1;
+	}
+	ok = job.cks && job.n == nstages;
+	if (ok && job.opts->edge == EDGE_WRAP)
+		ok = pipe_sequential(img_blur, img, &job);
+	else if (ok && img->w && img->h)
+	{
+		blur_tile_size(img->w, img->h, grow + 1, &tw, &th);
+		job.tw = job.opts->tile_w ? job.opts->tile_w : tw;
+		job.th = job.opts->tile_h ? job.opts->tile_h : th;
+		job.scratch = (job.tw + grow) * (job.th + grow), job.failed = 0;
+		blur_pool_run((img->h + job.th - 1) / job.th, pipe_job, &job);
+		ok = !job.failed;
+	}
+	while (job.cks && job.n)
+		kernel_free(job.cks[--job.n]);
+	free(job.cks);
+	return (ok);
+}
@@ -0,0 +1,150 @@
+#include "multithreading.h"
+
+#define PLANAR_ALIGN 64
+
+/**
+ * planar_create - program that allocates a planar image
+ * the three planes live in one block aligned on 64 bytes, and every row of
+ * every plane starts on a 64-byte boundary
+ * @w: the width of the image
+ * @h: the height of the image
+ * Return: a pointer to the planar image, to be released with planar_free,
+ *         or NULL on failure
+ */
+
+planar_t *planar_create(size_t w, size_t h)
+{
+	planar_t *planar = malloc(sizeof(*planar));
+	void *block = NULL;
+	size_t c;
+
+	if (!planar)
+		return (NULL);
+	planar->w = w;
+	planar->h = h;
+	planar->stride = (w + PLANAR_ALIGN - 1) / PLANAR_ALIGN * PLANAR_ALIGN;
+	if (posix_memalign(&block, PLANAR_ALIGN,
+			   3 * planar->stride * (h ? h : 1)))
+	{
+		free(planar);
+		return (NULL);
+	}
+	for (c = 0; c < 3; c++)
+		planar->planes[c] = (uint8_t *)block + c * planar->stride * h;
+	return (planar);
+}
+
+/**
+ * planar_free - program that releases a planar image
+ * @planar: a pointer to the planar image, may be NULL
+ * Return: nothing (void)
+ */
+
+void planar_free(planar_t *planar)
+{
+	if (!planar)
+		return;
+	free(planar->planes[0]);
+	free(planar);
+}
+
+/**
+ * planar_from_img - program that splits an interleaved image into the
+ * planes of a planar image of the same size
+ * rows are split 16 pixels at a time with SSSE3 when the CPU supports
+ * it, the remaining pixels one at a time
+ * @planar: a pointer to the destination planar image
+ * @img: a pointer to the source image
+ * Return: nothing (void)
+ */
+
+void planar_from_img(planar_t *planar, img_t const *img)
+{
+	pixel_t const *src;
+	uint8_t *rows[3];
+	size_t x, y, c;
+
+	for (y = 0; y < img->h; y++)
+	{
+		src = img->pixels + y * img->w;
+		for (c = 0; c < 3; c++)
+			rows[c] = planar->planes[c] + y * planar->stride;
+		x = 0;
+#if defined(__x86_64__) || defined(__i386__)
+		if (blur_simd_level() >= SIMD_SSE41)
+			x = planar_unpack_ssse3(src, rows, img->w);
+#endif
+		for (; x < img->w; x++)
+		{
+			rows[0][x] = src[x].r;
+			rows[1][x] = src[x].g;
+			rows[2][x] = src[x].b;
+		}
+	}
+}
+
+/**
+ * planar_to_img - program that interleaves the planes of a planar image
+ * into an image of the same size
+ * rows are interleaved 16 pixels at a time with SSSE3 when the CPU
+ * supports it, the remaining pixels one at a time
+ * @img: a pointer to the destination image
+ * @planar: a pointer to the source planar image
+ * Return: nothing (void)
+ */
+
+void planar_to_img(img_t *img, planar_t const *planar)
+{
+	uint8_t const *rows[3];
+	pixel_t *dst;
+	size_t x, y, c;
+
+	for (y = 0; y < img->h; y++)
+	{
+		dst = img->pixels + y * img->w;
+		for (c = 0; c < 3; c++)
+			rows[c] = planar->planes[c] + y * planar->stride;
+		x = 0;
+#if defined(__x86_64__) || defined(__i386__)
+		if (blur_simd_level() >= SIMD_SSE41)
+			x = planar_pack_ssse3(rows, dst, img->w);
+#endif
+		for (; x < img->w; x++)
+		{
+			dst[x].r = rows[0][x];
+			dst[x].g = rows[1][x];
+			dst[x].b = rows[2][x];
+		}
+	}
+}
+
+/**
+ * blur_image_planar - program that blurs an interleaved image through the
+ * planar layout
+ * the image is split into planes once, blurred plane by plane with
+ * blur_planar and interleaved back once
+ * @img_blur: a pointer to the output image data structure
+ * @img: a pointer to the input image data structure
+ * @ck: a pointer to the compiled kernel
+ * @opts: a pointer to the blur options, NULL for the defaults
+ * Return: 1 on success, 0 on failure
+ */
+
+int blur_image_planar(img_t *img_blur, img_t const *img, ckernel_t const *ck,
+		      blur_opts_t const *opts)
+{
+	planar_t *src = planar_create(img->w, img->h);
+	planar_t *dst = planar_create(img->w, img->h);
+	int ok = 0;
+
+	if (src && dst)
+	{
+		planar_from_img(src, img);
+		ok = blur_planar(dst, src, ck, opts);
+		if (ok)
+			planar_to_img(img_blur, dst);
+	}
+	planar_free(src);
+	planar_free(dst);
+	return (ok);
+}
@@ -0,0 +1,238 @@
+#include "multithreading.h"
+
+#define COL_LO(dx) ((dx) < 0 ? (size_t)-(dx) : 0)
+#define COL_HI(dx, w) ((dx) > 0 ? ((size_t)(dx) < (w) ? (w) - (dx) : 0) : (w))
+
+/**
+ * struct planar_job_s - Argument of the pool job blurring a planar image
+ * @dst:    the destination planar image
+ * @src:    the source planar image
+ * @ck:     the compiled kernel
+ * @band:   number of rows of the bands the planes are split into
+ * @nbands: number of bands per plane
+ * @wsum:   per column sum of the in-bounds weights: of @ck->row for a
+ *          separable kernel, of every tap otherwise
+ * @failed: set by a job that could not allocate its rows
+ */
+
+typedef struct planar_job_s
+{
+	planar_t *dst;
+	planar_t const *src;
+	ckernel_t const *ck;
+	size_t band;
+	size_t nbands;
+	float *wsum;
+	int failed;
+} planar_job_t;
+
+/**
+ * plane_h - program that runs the horizontal pass of a separable blur
+ * over the rows of one plane a band depends on
+ * every tap is swept over the range of columns it keeps inside the plane,
+ * so the inner loop is a contiguous, branch-free multiply-add
+ * @job: a pointer to the planar job
+ * @src: a pointer to the first row of the source plane
+ * @y0: the first row to filter
+ * @y1: the row past the last row to filter
+ * @tmp: receives one float row of src->w values per filtered row
+ * Return: nothing (void)
+ */
+
+static void plane_h(planar_job_t const *job, uint8_t const *src,
+		    size_t y0, size_t y1, float *tmp)
+{
+	size_t x, y, k, lo, hi, w = job->src->w, r = job->ck->size / 2;
+	long dx;
+	uint8_t const *s;
+	float *out;
+
+	for (y = y0; y < y1; y++)
+	{
+		out = tmp + (y - y0) * w;
+		s = src + y * job->src->stride;
+		for (x = 0; x < w; x++)
+			out[x] = 0;
+		for (k = 0; k < job->ck->size; k++)
+		{
+			dx = (long)k - (long)r;
+			lo = COL_LO(dx), hi = COL_HI(dx, w);
+			if (lo < hi)
+				planar_row_madd_u8(out + lo, s + lo + dx,
+						   job->ck->row[k], hi - lo);
+		}
+	}
+}
+
+/**
+ * plane_v - program that runs the vertical pass of a separable blur over
+ * one band of one plane, normalizing by the product of the in-bounds row
+ * and column weights like blur_portion_separable
+ * @job: a pointer to the planar job
+ * @dst: a pointer to the first row of the destination plane
+ * @y: the first row of the band
+ * @h: the number of rows of the band
+ * @tmp: the rows filtered by plane_h, starting at row y - radius or 0
+ * Return: nothing (void)
+ */
+
+static void plane_v(planar_job_t const *job, uint8_t *dst, size_t y,
+		    size_t h, float const *tmp)
+{
+	size_t x, k, w = job->src->w, r = job->ck->size / 2;
+	size_t y0 = y > r ? y - r : 0, end = y + h;
+	float *acc = (float *)tmp + (y + h + r - y0) * w, wc;
+	long sy;
+
+	for (; y < end; y++)
+	{
+		for (x = 0; x < w; x++)
+			acc[x] = 0;
+		for (wc = 0, k = 0; k < job->ck->size; k++)
+		{
+			sy = (long)(y + k) - (long)r;
+			if (sy < 0 || sy >= (long)job->src->h)
+				continue;
+			planar_row_madd_f32(acc, tmp + (sy - y0) * w,
+					    job->ck->col[k], w);
+			wc += job->ck->col[k];
+		}
+		for (x = 0; x < w; x++)
+			dst[y * job->dst->stride + x] =
+				acc[x] / (wc * job->wsum[x]);
+	}
+}
+
+/**
+ * plane_direct - program that blurs one band of one plane with the direct
+ * convolution
+ * each non-zero tap is swept over the columns it keeps inside the plane;
+ * on rows far enough from the top and bottom borders the per column total
+ * of in-bounds weights is the precomputed @job->wsum, elsewhere it is
+ * accumulated along with the taps, in the same order as blur_portion
+ * @job: a pointer to the planar job
+ * @c: the plane to blur
+ * @y: the first row of the band
+ * @h: the number of rows of the band
+ * @acc: scratch room for two float rows of src->w values
+ * Return: nothing (void)
+ */
+
+static void plane_direct(planar_job_t const *job, size_t c, size_t y,
+			 size_t h, float *acc)
+{
+	ckernel_t const *ck = job->ck;
+	size_t x, t, lo, hi, w = job->src->w, end = y + h, r = ck->size / 2;
+	float *ws;
+	long sy;
+
+	for (; y < end; y++)
+	{
+		ws = acc + w;
+		if (y >= r && y + ck->size - r <= job->src->h)
+			ws = job->wsum;
+		for (x = 0; x < w; x++)
+			acc[x] = 0, acc[w + x] = 0;
+		for (t = 0; t < ck->ntaps; t++)
+		{
+			sy = (long)y + ck->tap_y[t];
+			if (sy < 0 || sy >= (long)job->src->h)
+				continue;
+			lo = COL_LO(ck->tap_x[t]), hi = COL_HI(ck->tap_x[t], w);
+			planar_row_madd_u8(acc + lo, job->src->planes[c] + sy *
+					   job->src->stride + lo + ck->tap_x[t],
+					   ck->tap_w[t], hi > lo ? hi - lo : 0);
+			for (x = lo; ws != job->wsum && x < hi; x++)
+				ws[x] += ck->tap_w[t];
+		}
+		for (x = 0; x < w; x++)
+			job->dst->planes[c][y * job->dst->stride + x] =
+				acc[x] / ws[x];
+	}
+}
+
+/**
+ * planar_job - pool job program that blurs one band of one plane
+ * a job that cannot allocate its rows marks the blur as failed, its band
+ * being left unwritten
+ * @arg: a pointer to the planar_job_t describing the job
+ * @i: the index of the band, plane-major
+ * Return: nothing (void)
+ */
+
+static void planar_job(void *arg, size_t i)
+{
+	planar_job_t *job = arg;
+	size_t c = i / job->nbands, y = (i % job->nbands) * job->band;
+	size_t h = job->src->h - y < job->band ? job->src->h - y : job->band;
+	size_t rows = job->ck->separable ? h + job->ck->size + 1 : 2;
+	float *tmp = malloc(sizeof(float) * job->src->w * rows);
+	size_t r = job->ck->size / 2, y0 = y > r ? y - r : 0;
+	size_t y1 = y + h + r < job->src->h ? y + h + r : job->src->h;
+
+	if (!tmp)
+	{
+		fprintf(stderr, "blur_planar: malloc failed\n");
+		__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	if (job->ck->separable)
+	{
+		plane_h(job, job->src->planes[c], y0, y1, tmp);
+		plane_v(job, job->dst->planes[c], y, h, tmp);
+	}
+	else
+		plane_direct(job, c, y, h, tmp);
+	free(tmp);
+}
+
+/**
+ * blur_planar - program that blurs a planar image plane by plane
+ * the planes are split into bands of rows, every band of every plane
+ * being an item of a job on the blur pool; the pixels close to the
+ * borders are renormalized, the other edge modes are not supported
+ * @dst: a pointer to the destination planar image, of the size of src
+ * @src: a pointer to the source planar image
+ * @ck: a pointer to the compiled kernel
+ * @opts: a pointer to the blur options, NULL for the defaults; tile_h
+ *        sets the height of the bands
+ * Return: 1 on success, 0 on failure
+ */
+
+int blur_planar(planar_t *dst, planar_t const *src, ckernel_t const *ck,
+		blur_opts_t const *opts)
+{
+	planar_job_t job;
+	size_t x, k, n, tw;
+	long dx;
+	float wk;
+
+	if (!dst || !src || !ck || dst->w != src->w || dst->h != src->h)
+		return (0);
+	if (opts && opts->edge != EDGE_RENORMALIZE)
+	{
+		fprintf(stderr, "blur_planar: unsupported edge mode\n");
+		return (0);
+	}
+	if (!src->w || !src->h)
+		return (1);
+	blur_tile_size(src->w, src->h, ck->size, &tw, &job.band);
+	job.band = opts && opts->tile_h ? opts->tile_h : job.band;
+	job.nbands = (src->h + job.band - 1) / job.band;
+	job.dst = dst, job.src = src, job.ck = ck, job.failed = 0;
+	job.wsum = calloc(src->w, sizeof(float));
+	if (!job.wsum)
+		return (0);
+	n = ck->separable ? ck->size : ck->ntaps;
+	for (k = 0; k < n; k++)
+	{
+		dx = (long)k - (long)(ck->size / 2);
+		dx = ck->separable ? dx : ck->tap_x[k];
+		wk = ck->separable ? ck->row[k] : ck->tap_w[k];
+		for (x = COL_LO(dx); x < COL_HI(dx, src->w); x++)
+			job.wsum[x] += wk;
+	}
+	blur_pool_run(3 * job.nbands, planar_job, &job);
+	free(job.wsum);
+	return (!job.failed);
+}
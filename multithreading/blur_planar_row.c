@@ -0,0 +1,49 @@
+#include "multithreading.h"
+
+/**
+ * planar_row_madd_u8 - program that adds a row of a plane, scaled by a
+ * weight, to a row of float accumulators
+ * the bulk of the row goes through AVX2 when the selected instruction set
+ * allows it, the remaining values one at a time
+ * @acc: the accumulators
+ * @s: the row of the plane
+ * @w: the weight
+ * @n: the number of values
+ * Return: nothing (void)
+ */
+
+void planar_row_madd_u8(float *acc, uint8_t const *s, float w, size_t n)
+{
+	size_t i = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+	if (blur_simd_level() >= SIMD_AVX2)
+		i = planar_madd_u8_avx2(acc, s, w, n);
+#endif
+	for (; i < n; i++)
+		acc[i] += s[i] * w;
+}
+
+/**
+ * planar_row_madd_f32 - program that adds a row of floats, scaled by a
+ * weight, to a row of float accumulators
+ * the bulk of the row goes through AVX2 when the selected instruction set
+ * allows it, the remaining values one at a time
+ * @acc: the accumulators
+ * @s: the row of floats
+ * @w: the weight
+ * @n: the number of values
+ * Return: nothing (void)
+ */
+
+void planar_row_madd_f32(float *acc, float const *s, float w, size_t n)
+{
+	size_t i = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+	if (blur_simd_level() >= SIMD_AVX2)
+		i = planar_madd_f32_avx2(acc, s, w, n);
+#endif
+	for (; i < n; i++)
+		acc[i] += w * s[i];
+}
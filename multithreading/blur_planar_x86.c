@@ -0,0 +1,174 @@
+#include "multithreading.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#define U8_PS256(p) _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32( \
+	_mm_loadl_epi64((__m128i const *)(p))))
+#define SHUF _mm_shuffle_epi8
+#define LOAD(p) _mm_loadu_si128((__m128i const *)(p))
+#define ACC_ADD(p, v) _mm256_storeu_ps((p), \
+	_mm256_add_ps(_mm256_loadu_ps(p), (v)))
+
+/**
+ * planar_masks - program that builds the byte shuffles moving the channels
+ * of 16 interleaved RGB pixels (48 bytes, three 16-byte chunks) to or from
+ * three 16-byte planes
+ * mask[chunk][channel] selects, for every byte of the destination, the
+ * byte of the source that goes there, or -1 for none
+ * @masks: receives the unpack (pack = 0) or pack (pack = 1) masks
+ * @pack: whether to build the masks of planar_pack_ssse3
+ * Return: nothing (void)
+ */
+
+static void planar_masks(int8_t masks[3][3][16], int pack)
+{
+	size_t q, c, j;
+	int s;
+
+	for (q = 0; q < 3; q++)
+		for (c = 0; c < 3; c++)
+			for (j = 0; j < 16; j++)
+			{
+				s = pack ? 16 * q + j : 3 * j + c;
+				if (pack)
+					s = s % 3 == (int)c ? s / 3 : -1;
+				else
+					s = s / 16 == (int)q ? s % 16 : -1;
+				masks[q][c][j] = s;
+			}
+}
+
+/**
+ * planar_unpack_ssse3 - program that splits a row of interleaved RGB
+ * pixels into three planes, 16 pixels per iteration
+ * @src: a pointer to the first pixel of the row
+ * @planes: the red, green and blue rows to write
+ * @n: the number of pixels of the row
+ * Return: the number of pixels processed, a multiple of 16
+ */
+
+__attribute__((target("ssse3")))
+size_t planar_unpack_ssse3(pixel_t const *src, uint8_t *const planes[3],
+			   size_t n)
+{
+	int8_t m[3][3][16];
+	__m128i mask[3][3], in[3], out;
+	uint8_t const *bytes = (uint8_t const *)src;
+	size_t i, q, c;
+
+	planar_masks(m, 0);
+	for (q = 0; q < 3; q++)
+		for (c = 0; c < 3; c++)
+			mask[q][c] = LOAD(m[q][c]);
+	for (i = 0; i + 16 <= n; i += 16, bytes += 48)
+	{
+		for (q = 0; q < 3; q++)
+			in[q] = LOAD(bytes + 16 * q);
+		for (c = 0; c < 3; c++)
+		{
+			out = _mm_or_si128(SHUF(in[0], mask[0][c]),
+					   SHUF(in[1], mask[1][c]));
+			out = _mm_or_si128(out, SHUF(in[2], mask[2][c]));
+			_mm_storeu_si128((__m128i *)(planes[c] + i), out);
+		}
+	}
+	return (i);
+}
+
+/**
+ * planar_pack_ssse3 - program that interleaves three planes into a row of
+ * RGB pixels, 16 pixels per iteration
+ * @planes: the red, green and blue rows to read
+ * @dst: a pointer to the first pixel of the row
+ * @n: the number of pixels of the row
+ * Return: the number of pixels processed, a multiple of 16
+ */
+
+__attribute__((target("ssse3")))
+size_t planar_pack_ssse3(uint8_t const *const planes[3], pixel_t *dst,
+			 size_t n)
+{
+	int8_t m[3][3][16];
+	__m128i mask[3][3], in[3], out;
+	uint8_t *bytes = (uint8_t *)dst;
+	size_t i, q, c;
+
+	planar_masks(m, 1);
+	for (q = 0; q < 3; q++)
+		for (c = 0; c < 3; c++)
+			mask[q][c] = LOAD(m[q][c]);
+	for (i = 0; i + 16 <= n; i += 16, bytes += 48)
+	{
+		for (c = 0; c < 3; c++)
+			in[c] = LOAD(planes[c] + i);
+		for (q = 0; q < 3; q++)
+		{
+			out = _mm_or_si128(SHUF(in[0], mask[q][0]),
+					   SHUF(in[1], mask[q][1]));
+			out = _mm_or_si128(out, SHUF(in[2], mask[q][2]));
+			_mm_storeu_si128((__m128i *)bytes + q, out);
+		}
+	}
+	return (i);
+}
+
+/**
+ * planar_madd_u8_avx2 - program that adds a row of a plane, scaled by a
+ * weight, to a row of float accumulators, 16 values per iteration
+ * the product and the sum are rounded separately, like the scalar loop
+ * @acc: the accumulators
+ * @s: the row of the plane
+ * @w: the weight
+ * @n: the number of values
+ * Return: the number of values processed, a multiple of 16
+ */
+
+__attribute__((target("avx2")))
+size_t planar_madd_u8_avx2(float *acc, uint8_t const *s, float w, size_t n)
+{
+	__m256 wt = _mm256_set1_ps(w), a, b;
+	size_t i;
+
+	for (i = 0; i + 16 <= n; i += 16)
+	{
+		a = _mm256_mul_ps(wt, U8_PS256(s + i));
+		b = _mm256_mul_ps(wt, U8_PS256(s + i + 8));
+		ACC_ADD(acc + i, a);
+		ACC_ADD(acc + i + 8, b);
+	}
+	return (i);
+}
+
+/**
+ * planar_madd_f32_avx2 - program that adds a row of floats, scaled by a
+ * weight, to a row of float accumulators, 16 values per iteration
+ * @acc: the accumulators
+ * @s: the row of floats
+ * @w: the weight
+ * @n: the number of values
+ * Return: the number of values processed, a multiple of 16
+ */
+
+__attribute__((target("avx2")))
+size_t planar_madd_f32_avx2(float *acc, float const *s, float w, size_t n)
+{
+	__m256 wt = _mm256_set1_ps(w), a, b;
+	size_t i;
+
+	for (i = 0; i + 16 <= n; i += 16)
+	{
+		a = _mm256_mul_ps(wt, _mm256_loadu_ps(s + i));
+		b = _mm256_mul_ps(wt, _mm256_loadu_ps(s + i + 8));
+		ACC_ADD(acc + i, a);
+		ACC_ADD(acc + i + 8, b);
+	}
+	return (i);
+}
+
+#else
+
+typedef int blur_planar_x86_unused_t;
+
+#endif /* __x86_64__ || __i386__ */
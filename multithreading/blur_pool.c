@@ -0,0 +1,236 @@
+#include "multithreading.h"
+
+#include <unistd.h>
+
+/**
+ * struct blur_pool_s - Long-lived pool of blur workers
+ * @start:      serializes the lazy starts of the pool by blur_pool_size
+ * @submit:     held by the job running on the workers, and by
+ *              blur_pool_init and blur_pool_shutdown
+ * @lock:       protects the fields below
+ * @wake:       signaled when a job is published or the pool stops
+ * @done:       signaled when the last worker leaves a job
+ * @threads:    worker threads, the caller of blur_pool_run excluded
+ * @nthreads:   number of worker threads, the caller included
+ * @generation: incremented every time a job is published
+ * @stop:       set to ask the workers to exit
+ * @fn:         function of the current job
+ * @arg:        argument of the current job
+ * @count:      number of items of the current job
+ * @ranges:     items of the current job left to hand out, split by node
+ * @limit:      number of workers taking part in the current job, the
+ *              caller included (see blur_pool_limit)
+ * @active:     number of workers that have not left the current job yet
+ * @started:    number of workers started, to number them for
+ *              blur_pool_pin
+ * @running:    set once the pool is started, even if no worker thread
+ *              could be created, so that it is not started again
+ */
+
+static struct blur_pool_s
+{
+	pthread_mutex_t start;
+	pthread_mutex_t submit;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t done;
+	pthread_t *threads;
+	size_t nthreads;
+	unsigned long generation;
+	int stop;
+	pool_job_t fn;
+	void *arg;
+	size_t count;
+	pool_ranges_t ranges;
+	size_t limit;
+	size_t active;
+	size_t started;
+	int running;
+} pool = {
+	PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+	NULL, 1, 0, 0, NULL, NULL, 0, {{0}, {0}, 0, 0}, 0, 0, 0, 0
+};
+
+static __thread int in_job;
+
+/**
+ * pool_worker - thread entry program of the blur workers
+ * a worker is first pinned according to the placement policy; it parks
+ * on a condition variable between jobs; once woken up for a new job it
+ * pulls items from the ranges of the job, its home range first, until
+ * there is none left, then reports that it left the job; a worker whose
+ * number is past the limit of the job sits it out
+ * @arg: the generation of the pool when the worker was created, so that a
+ *       job published before the worker first takes the lock is not missed
+ * Return: NULL once the pool is shut down
+ */
+
+static void *pool_worker(void *arg)
+{
+	unsigned long seen = (unsigned long)arg;
+	pool_job_t fn;
+	size_t i, count, home, id;
+
+	in_job = 1;
+	id = __atomic_add_fetch(&pool.started, 1, __ATOMIC_RELAXED);
+	home = blur_pool_pin(id, NULL);
+	pthread_mutex_lock(&pool.lock);
+	for (; ; seen = pool.generation)
+	{
+		while (!pool.stop && pool.generation == seen)
+			pthread_cond_wait(&pool.wake, &pool.lock);
+		if (pool.stop)
+			break;
+		if (id >= pool.limit)
+			continue;
+		fn = pool.fn, arg = pool.arg, count = pool.count;
+		pthread_mutex_unlock(&pool.lock);
+		while ((i = pool_ranges_claim(&pool.ranges, home)) < count)
+			fn(arg, i);
+		pthread_mutex_lock(&pool.lock);
+		if (--pool.active == 0)
+			pthread_cond_signal(&pool.done);
+	}
+	pthread_mutex_unlock(&pool.lock);
+	return (NULL);
+}
+
+/**
+ * blur_pool_shutdown - program that stops and joins the blur workers
+ * this function is marked with the destructor attribute, so a pool that
+ * is still running when the program exits is shut down cleanly; the pool
+ * may be initialized again afterwards
+ * Return: nothing (void)
+ */
+
+__attribute__((destructor))
+void blur_pool_shutdown(void)
+{
+	size_t i;
+
+	pthread_mutex_lock(&pool.submit);
+	pthread_mutex_lock(&pool.lock);
+	pool.stop = 1;
+	pthread_cond_broadcast(&pool.wake);
+	pthread_mutex_unlock(&pool.lock);
+	for (i = 0; pool.threads && i + 1 < pool.nthreads; i++)
+		pthread_join(pool.threads[i], NULL);
+	free(pool.threads);
+	pool.threads = NULL;
+	__atomic_store_n(&pool.nthreads, 1, __ATOMIC_RELAXED);
+	__atomic_store_n(&pool.running, 0, __ATOMIC_RELEASE);
+	pool.stop = 0;
+	pthread_mutex_unlock(&pool.submit);
+}
+
+/**
+ * blur_pool_init - program that starts the long-lived pool of blur workers
+ * a running pool is shut down first; the caller of blur_pool_run counts as
+ * one of the workers, so nthreads - 1 threads are created
+ * @nthreads: the number of workers; 0 selects the BLUR_THREADS environment
+ *            variable if set, the number of online processors otherwise
+ * Return: the number of workers actually started, the caller included
+ */
+
+size_t blur_pool_init(size_t nthreads)
+{
+	char const *env = getenv("BLUR_THREADS");
+	long online = sysconf(_SC_NPROCESSORS_ONLN);
+	pthread_t *threads;
+	size_t i, started;
+
+	if (!nthreads && env)
+		nthreads = strtoul(env, NULL, 10);
+	if (!nthreads)
+		nthreads = online > 0 ? (size_t)online : 1;
+	blur_pool_shutdown();
+	pthread_mutex_lock(&pool.submit);
+	pool.started = 0;
+	threads = malloc(sizeof(pthread_t) * nthreads);
+	for (i = 0; threads && i + 1 < nthreads; i++)
+		if (pthread_create(threads + i, NULL, pool_worker,
+				   (void *)pool.generation))
+			break;
+	started = threads ? i + 1 : 1;
+	pool.threads = threads;
+	__atomic_store_n(&pool.nthreads, started, __ATOMIC_RELAXED);
+	__atomic_store_n(&pool.running, 1, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&pool.submit);
+	if (started < nthreads)
+		fprintf(stderr, "blur_pool_init: pthread_create failed\n");
+	return (started);
+}
+
+/**
+ * blur_pool_size - program that reports the number of blur workers,
+ * starting the pool with its default size if it is not running yet
+ * the pool is checked again under the start lock, so threads making their
+ * first blur call at the same time start it once, and none of them shuts
+ * down the pool another one just started; a pool that could not create
+ * its threads runs with the caller alone and is not started again
+ * Return: the number of workers, the caller of blur_pool_run included
+ */
+
+size_t blur_pool_size(void)
+{
+	if (!__atomic_load_n(&pool.running, __ATOMIC_ACQUIRE))
+	{
+		pthread_mutex_lock(&pool.start);
+		if (!__atomic_load_n(&pool.running, __ATOMIC_ACQUIRE))
+			blur_pool_init(0);
+		pthread_mutex_unlock(&pool.start);
+	}
+	return (__atomic_load_n(&pool.nthreads, __ATOMIC_RELAXED));
+}
+
+/**
+ * blur_pool_run - program that runs a job on the blur workers
+ * fn is called once for every item in [0, count), the items being handed
+ * out through shared atomic counters so that fast workers take more of
+ * them; with POOL_NODES the items are split into one contiguous range per
+ * NUMA node, claimed first by the workers of that node; the caller works
+ * on the job too and returns once every worker has left it; a job
+ * submitted from inside another job runs inline; only the number of
+ * workers set by blur_pool_limit for the calling thread take part;
+ * the pool runs one job at a time: a job submitted while another one
+ * holds the workers runs inline on its caller rather than waiting, so
+ * concurrent callers (batch stages, the pipeline, the tuner) are not
+ * serialized behind each other but each get a single thread
+ * @count: the number of items of the job
+ * @fn: the function called for every item
+ * @arg: the argument passed to fn along with the item
+ * Return: nothing (void)
+ */
+
+void blur_pool_run(size_t count, pool_job_t fn, void *arg)
+{
+	size_t i, home, nranges, limit;
+
+	limit = in_job ? 1 : pool_job_limit(blur_pool_size());
+	if (count < 2 || limit < 2 || pthread_mutex_trylock(&pool.submit))
+	{
+		for (i = 0; i < count; i++)
+			fn(arg, i);
+		return;
+	}
+	home = blur_pool_pin(0, &nranges);
+	pthread_mutex_lock(&pool.lock);
+	pool.fn = fn, pool.arg = arg, pool.count = count;
+	pool_ranges_split(&pool.ranges, count, nranges);
+	pool.limit = limit < pool.nthreads ? limit : pool.nthreads;
+	pool.active = pool.limit - 1;
+	pool.generation++;
+	pthread_cond_broadcast(&pool.wake);
+	pthread_mutex_unlock(&pool.lock);
+	in_job = 1;
+	while ((i = pool_ranges_claim(&pool.ranges, home)) < count)
+		fn(arg, i);
+	in_job = 0;
+	pthread_mutex_lock(&pool.lock);
+	while (pool.active)
+		pthread_cond_wait(&pool.done, &pool.lock);
+	pthread_mutex_unlock(&pool.lock);
+	pthread_mutex_unlock(&pool.submit);
+}
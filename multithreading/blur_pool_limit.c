@@ -0,0 +1,34 @@
+#include "multithreading.h"
+
+static __thread size_t pool_limit;
+
+/**
+ * blur_pool_limit - program that limits the number of blur workers taking
+ * part in the jobs the calling thread submits, without resizing the pool
+ * the limit belongs to the calling thread, so the other callers of the
+ * pool keep every worker, and the workers left out of a job stay parked
+ * @nthreads: the number of workers, the caller of blur_pool_run included;
+ *            0 lifts the limit
+ * Return: the previous limit, to be restored by the caller
+ */
+
+size_t blur_pool_limit(size_t nthreads)
+{
+	size_t prev = pool_limit;
+
+	pool_limit = nthreads;
+	return (prev);
+}
+
+/**
+ * pool_job_limit - program that gives the number of workers a job of the
+ * calling thread may use
+ * @nthreads: the number of workers of the pool
+ * Return: the limit set by blur_pool_limit, at most nthreads, or nthreads
+ *         if there is none
+ */
+
+size_t pool_job_limit(size_t nthreads)
+{
+	return (pool_limit && pool_limit < nthreads ? pool_limit : nthreads);
+}
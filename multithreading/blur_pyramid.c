@@ -0,0 +1,183 @@
+#include "multithreading.h"
+
+#define PYRAMID_BAND 16
+#define CLAMP_INDEX(i, n) \
+	((i) < 0 ? 0 : (i) >= (long)(n) ? (long)(n) - 1 : (i))
+
+/**
+ * struct reduce_job_s - Argument of the pool jobs of a pyramid reduction
+ * @src: the finer level
+ * @dst: the coarser level, half the size of @src rounded up
+ * @failed: set by a job that could not allocate its accumulators
+ */
+
+typedef struct reduce_job_s
+{
+	img_t const *src;
+	img_t *dst;
+	int failed;
+} reduce_job_t;
+
+/**
+ * reduce_row - program that filters a row of a finer pyramid level with
+ * the 5-tap binomial filter at every even column, and accumulates it with
+ * a weight
+ * @row: the row of the finer level
+ * @w: the width of the finer level
+ * @acc: the RGB accumulators of the coarser row
+ * @dw: the width of the coarser level
+ * @wy: the weight of the row
+ * Return: nothing (void)
+ */
+
+static void reduce_row(pixel_t const *row, size_t w, uint32_t *acc,
+		       size_t dw, uint32_t wy)
+{
+	static uint32_t const wx[5] = {1, 4, 6, 4, 1};
+	uint32_t s[3];
+	pixel_t const *p;
+	size_t X, i;
+
+	for (X = 0; X < dw; X++, acc += 3)
+	{
+		for (i = 0, s[0] = s[1] = s[2] = 0; i < 5; i++)
+		{
+			p = row + CLAMP_INDEX((long)(2 * X + i) - 2, w);
+			s[0] += wx[i] * p->r, s[1] += wx[i] * p->g;
+			s[2] += wx[i] * p->b;
+		}
+		acc[0] += wy * s[0], acc[1] += wy * s[1], acc[2] += wy * s[2];
+	}
+}
+
+/**
+ * reduce_job - pool job program that computes a band of rows of a coarser
+ * pyramid level
+ * every output pixel is the 5 x 5 binomial average (weights 1 4 6 4 1
+ * along both axes) of the finer pixels around its even position, the
+ * borders being clamped; the sums are exact in integers and rounded once;
+ * a job that cannot allocate its accumulators marks the reduction as
+ * failed, its band being left unwritten
+ * @arg: a pointer to the reduce_job_t describing the reduction
+ * @band: the index of the band of PYRAMID_BAND rows
+ * Return: nothing (void)
+ */
+
+static void reduce_job(void *arg, size_t band)
+{
+	static uint32_t const wy[5] = {1, 4, 6, 4, 1};
+	reduce_job_t *job = arg;
+	img_t const *src = job->src;
+	size_t X, Y, j, dw = job->dst->w, end = (band + 1) * PYRAMID_BAND;
+	uint32_t *acc = malloc(sizeof(uint32_t) * 3 * dw);
+	pixel_t *out;
+	long y;
+
+	for (Y = band * PYRAMID_BAND; acc && Y < end && Y < job->dst->h; Y++)
+	{
+		for (X = 0; X < 3 * dw; X++)
+			acc[X] = 0;
+		for (j = 0; j < 5; j++)
+		{
+			y = CLAMP_INDEX((long)(2 * Y + j) - 2, src->h);
+			reduce_row(src->pixels + y * src->w, src->w, acc, dw,
+				   wy[j]);
+		}
+		out = job->dst->pixels + Y * dw;
+		for (X = 0; X < dw; X++)
+		{
+			out[X].r = (acc[3 * X] + 128) >> 8;
+			out[X].g = (acc[3 * X + 1] + 128) >> 8;
+			out[X].b = (acc[3 * X + 2] + 128) >> 8;
+		}
+	}
+	if (!acc)
+	{
+		fprintf(stderr, "pyramid_level: out of memory\n");
+		__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+	}
+	free(acc);
+}
+
+/**
+ * pyramid_create - program that starts the Gaussian pyramid of an image
+ * the coarser levels are built on demand by pyramid_level and kept, so
+ * later blurs of the same image reuse them; the pyramid must be freed and
+ * created again once the pixels of the image change
+ * @img: a pointer to the image, which must outlive the pyramid
+ * Return: a pointer to the pyramid, to be released with pyramid_free, or
+ *         NULL on failure
+ */
+
+pyramid_t *pyramid_create(img_t const *img)
+{
+	pyramid_t *pyr;
+
+	if (!img || !img->pixels)
+		return (NULL);
+	pyr = malloc(sizeof(*pyr));
+	if (!pyr)
+		return (NULL);
+	pyr->nlevels = 1;
+	pyr->levels[0] = *img;
+	return (pyr);
+}
+
+/**
+ * pyramid_level - program that gets a level of a Gaussian pyramid,
+ * building the levels missing up to it on the blur pool
+ * a level of 1 x 1 pixels is the last one; a level that could not be
+ * built completely is not kept, so a later call builds it again
+ * @pyr: a pointer to the pyramid
+ * @level: the index of the level, 0 being the image itself
+ * Return: a pointer to the level, or NULL if it does not exist or could
+ *         not be built
+ */
+
+img_t const *pyramid_level(pyramid_t *pyr, size_t level)
+{
+	reduce_job_t job;
+	img_t *dst;
+
+	if (level >= PYRAMID_MAX_LEVELS)
+		return (NULL);
+	while (pyr->nlevels <= level)
+	{
+		job.src = pyr->levels + pyr->nlevels - 1;
+		if (job.src->w < 2 && job.src->h < 2)
+			return (NULL);
+		dst = job.dst = pyr->levels + pyr->nlevels;
+		dst->w = (job.src->w + 1) / 2, dst->h = (job.src->h + 1) / 2;
+		dst->pixels = malloc(sizeof(pixel_t) * dst->w * dst->h);
+		if (!dst->pixels)
+			return (NULL);
+		job.failed = 0;
+		blur_pool_run((dst->h + PYRAMID_BAND - 1) / PYRAMID_BAND,
+			      reduce_job, &job);
+		if (job.failed)
+		{
+			free(dst->pixels);
+			return (NULL);
+		}
+		pyr->nlevels++;
+	}
+	return (pyr->levels + level);
+}
+
+/**
+ * pyramid_free - program that releases a Gaussian pyramid, but not the
+ * image it was built from
+ * @pyr: a pointer to the pyramid, may be NULL
+ * Return: nothing (void)
+ */
+
+void pyramid_free(pyramid_t *pyr)
+{
+	size_t i;
+
+	if (!pyr)
+		return;
+	for (i = 1; i < pyr->nlevels; i++)
+		free(pyr->levels[i].pixels);
+	free(pyr);
+}
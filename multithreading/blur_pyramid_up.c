@@ -0,0 +1,189 @@
+#include "multithreading.h"
+
+#include <math.h>
+
+#define PYRAMID_SIGMA_MIN 1.0
+#define LERP(a, b, f) ((uint32_t)(a) * (256 - (f)) + (uint32_t)(b) * (f))
+#define BILERP(p, q, d, ch, fx, fy) \
+	((LERP((p)->ch, (p)[d].ch, fx) * (256 - (fy)) + \
+	  LERP((q)->ch, (q)[d].ch, fx) * (fy) + 32768) >> 16)
+
+/**
+ * struct up_job_s - Argument of the pool jobs of a pyramid upsampling
+ * @src:   the coarse image
+ * @dst:   the full resolution image
+ * @level: the level of @src, one of its pixels spanning 2^level pixels
+ * @x0:    the left coarse column of every full resolution column, followed
+ *         by the weight of the right column in 1/256
+ */
+
+typedef struct up_job_s
+{
+	img_t const *src;
+	img_t *dst;
+	size_t level;
+	size_t *x0;
+} up_job_t;
+
+/**
+ * pyramid_gauss - program that generates a normalized Gaussian kernel
+ * @sigma: the standard deviation, in pixels
+ * Return: a pointer to the kernel, whose matrix is one block to be
+ *         released with free along with the kernel, or NULL on failure
+ */
+
+static kernel_t *pyramid_gauss(double sigma)
+{
+	size_t r = sigma > 0 ? (size_t)ceil(3 * sigma) : 0, size = 2 * r + 1;
+	kernel_t *kernel = malloc(sizeof(*kernel));
+	double dx, dy;
+	size_t i, j;
+
+	if (!kernel)
+		return (NULL);
+	kernel->size = size;
+	kernel->matrix = malloc(sizeof(float *) * size +
+				sizeof(float) * size * size);
+	if (!kernel->matrix)
+	{
+		free(kernel);
+		return (NULL);
+	}
+	for (i = 0; i < size; i++)
+	{
+		kernel->matrix[i] = (float *)(kernel->matrix + size) + i * size;
+		for (j = 0; j < size; j++)
+		{
+			dx = (double)j - r, dy = (double)i - r;
+			dx = r ? -(dx * dx + dy * dy) / (2 * sigma * sigma) : 0;
+			kernel->matrix[i][j] = (float)exp(dx);
+		}
+	}
+	return (kernel);
+}
+
+/**
+ * up_job - pool job program that upsamples a band of rows of a coarse
+ * image to full resolution with bilinear interpolation
+ * full resolution pixel x lies at x / 2^level in the coarse image, the
+ * position of the coarse samples taken by the pyramid reduction
+ * @arg: a pointer to the up_job_t describing the upsampling
+ * @band: the index of the band of 16 rows
+ * Return: nothing (void)
+ */
+
+static void up_job(void *arg, size_t band)
+{
+	up_job_t const *job = arg;
+	size_t x, y, w = job->dst->w, sw = job->src->w, fx, fy, d;
+	size_t mask = ((size_t)1 << job->level) - 1, *x0 = job->x0;
+	pixel_t const *a, *c;
+	pixel_t *out;
+
+	for (y = band * 16; y < (band + 1) * 16 && y < job->dst->h; y++)
+	{
+		a = job->src->pixels + (y >> job->level) * sw;
+		c = (y >> job->level) + 1 < job->src->h ? a + sw : a;
+		fy = ((y & mask) << 8) >> job->level;
+		out = job->dst->pixels + y * w;
+		for (x = 0; x < w; x++, out++)
+		{
+			fx = x0[w + x], d = x0[x] + 1 < sw;
+			out->r = BILERP(a + x0[x], c + x0[x], d, r, fx, fy);
+			out->g = BILERP(a + x0[x], c + x0[x], d, g, fx, fy);
+			out->b = BILERP(a + x0[x], c + x0[x], d, b, fx, fy);
+		}
+	}
+}
+
+/**
+ * pyramid_pick - program that picks the pyramid level a Gaussian blur is
+ * run at
+ * reducing to level L blurs with a variance of (4^L - 1) / 3 and the
+ * bilinear upsampling adds about 4^L / 6, in full resolution pixels; the
+ * coarsest level leaving a residual blur of at least PYRAMID_SIGMA_MIN
+ * coarse pixels is picked, so the residual kernel stays small whatever
+ * the standard deviation
+ * @pyr: a pointer to the pyramid, whose levels are built as needed
+ * @sigma: the standard deviation of the blur, in full resolution pixels
+ * @res: receives the residual standard deviation, in pixels of the level
+ * Return: the level
+ */
+
+static size_t pyramid_pick(pyramid_t *pyr, double sigma, double *res)
+{
+	double s = 1, var;
+	size_t level = 0;
+
+	while (level + 1 < PYRAMID_MAX_LEVELS)
+	{
+		var = sigma * sigma - (4 * s - 1) / 3 - 4 * s / 6;
+		if (var < PYRAMID_SIGMA_MIN * PYRAMID_SIGMA_MIN * 4 * s ||
+		    !pyramid_level(pyr, level + 1))
+			break;
+		level++, s *= 4;
+	}
+	var = sigma * sigma - (s - 1) / 3 - (level ? s / 6 : 0);
+	*res = var > 0 ? sqrt(var / s) : 0;
+	return (level);
+}
+
+/**
+ * blur_pyramid - program that blurs an image with a Gaussian of a large
+ * standard deviation through its Gaussian pyramid
+ * the residual blur runs on a coarse level with a small kernel, then the
+ * result is upsampled to full resolution, so the cost stays close to that
+ * of a fixed small kernel whatever sigma; the levels built are kept in
+ * the pyramid for later calls; the reduction and the upsampling clamp
+ * the borders, the residual blur follows opts
+ * @img_blur: a pointer to the output image data structure, which must be
+ *            of the size of the image of the pyramid
+ * @pyr: a pointer to the pyramid of the image to blur
+ * @sigma: the standard deviation of the blur, in pixels
+ * @opts: a pointer to the blur options, NULL for the defaults
+ * Return: 1 on success, 0 on failure
+ */
+
+int blur_pyramid(img_t *img_blur, pyramid_t *pyr, float sigma,
+		 blur_opts_t const *opts)
+{
+	kernel_t *kernel;
+	up_job_t job;
+	img_t tmp;
+	double res;
+	size_t x, mask;
+
+	if (!img_blur || !pyr || !img_blur->pixels ||
+	    img_blur->w != pyr->levels[0].w || img_blur->h != pyr->levels[0].h)
+		return (0);
+	if (!img_blur->w || !img_blur->h)
+		return (1);
+	job.level = pyramid_pick(pyr, sigma, &res);
+	job.src = pyramid_level(pyr, job.level), job.dst = img_blur;
+	mask = ((size_t)1 << job.level) - 1;
+	kernel = pyramid_gauss(res);
+	tmp.w = job.src->w, tmp.h = job.src->h;
+	tmp.pixels = !job.level ? img_blur->pixels :
+		malloc(sizeof(pixel_t) * tmp.w * tmp.h);
+	job.x0 = malloc(sizeof(size_t) * 2 * img_blur->w);
+	if (kernel && tmp.pixels && job.x0)
+	{
+		blur_image_opts(&tmp, job.src, kernel, opts);
+		job.src = &tmp;
+		for (x = 0; x < img_blur->w; x++)
+		{
+			job.x0[x] = x >> job.level;
+			job.x0[img_blur->w + x] = ((x & mask) << 8) >>
+				job.level;
+		}
+		if (job.level)
+			blur_pool_run((img_blur->h + 15) / 16, up_job, &job);
+	}
+	if (job.level)
+		free(tmp.pixels);
+	free(job.x0);
+	if (kernel)
+		free(kernel->matrix);
+	free(kernel);
+	return (kernel && tmp.pixels && job.x0);
+}
@@ -0,0 +1,123 @@
+#include "multithreading.h"
+
+#include <string.h>
+
+#define TOUCH_ROWS 16
+
+/**
+ * pool_ranges_split - program that splits the items of a pool job into
+ * contiguous ranges of the same size
+ * @r: a pointer to the ranges
+ * @count: the number of items of the job
+ * @n: the number of ranges, at most POOL_MAX_NODES
+ * Return: nothing (void)
+ */
+
+void pool_ranges_split(pool_ranges_t *r, size_t count, size_t n)
+{
+	size_t k;
+
+	r->n = n ? (n < POOL_MAX_NODES ? n : POOL_MAX_NODES) : 1;
+	r->count = count;
+	for (k = 0; k < r->n; k++)
+	{
+		r->next[k] = k * count / r->n;
+		r->end[k] = (k + 1) * count / r->n;
+	}
+}
+
+/**
+ * pool_ranges_claim - program that hands out the next item of a pool job
+ * the item is taken from the home range of the caller while it has some
+ * left, then from the other ranges in turn, so that a node running out
+ * of work helps the others instead of idling
+ * @r: a pointer to the ranges
+ * @home: the range to claim from first
+ * Return: the item, or r->count once every item is handed out
+ */
+
+size_t pool_ranges_claim(pool_ranges_t *r, size_t home)
+{
+	size_t k, j, i;
+
+	for (k = 0; k < r->n; k++)
+	{
+		j = (home + k) % r->n;
+		if (__atomic_load_n(&r->next[j], __ATOMIC_RELAXED) >= r->end[j])
+			continue;
+		i = __atomic_fetch_add(&r->next[j], 1, __ATOMIC_RELAXED);
+		if (i < r->end[j])
+			return (i);
+	}
+	return (r->count);
+}
+
+/**
+ * touch_job - pool job program that zeroes a band of rows of an image
+ * @arg: a pointer to the img_t
+ * @band: the index of the band of TOUCH_ROWS rows
+ * Return: nothing (void)
+ */
+
+static void touch_job(void *arg, size_t band)
+{
+	img_t *img = arg;
+	size_t y = band * TOUCH_ROWS;
+	size_t rows = img->h - y < TOUCH_ROWS ? img->h - y : TOUCH_ROWS;
+
+	memset(img->pixels + y * img->w, 0, sizeof(pixel_t) * img->w * rows);
+}
+
+/**
+ * blur_image_alloc - program that allocates the pixels of an image so that
+ * every band of rows is first touched by the blur workers of the node
+ * that later blurs it
+ * the pages are zeroed through a pool job, whose ranges of bands follow
+ * the NUMA nodes with POOL_NODES the same way the tiles of blur_image do;
+ * with the other policies this is a plain zeroed allocation
+ * @img: a pointer to the image, whose pixels are to be released with free
+ * @w: the width of the image
+ * @h: the height of the image
+ * Return: 1 on success, 0 on failure
+ */
+
+int blur_image_alloc(img_t *img, size_t w, size_t h)
+{
+	img->w = w, img->h = h;
+	img->pixels = malloc(sizeof(pixel_t) * (w && h ? w * h : 1));
+	if (!img->pixels)
+		return (0);
+	blur_pool_run((h + TOUCH_ROWS - 1) / TOUCH_ROWS, touch_job, img);
+	return (1);
+}
+
+/**
+ * blur_pool_report - program that prints the placement of the blur workers
+ * one line gives the policy, the number of workers and of ranges, then
+ * one line per worker gives its processor and node
+ * @out: the stream to print to
+ * Return: nothing (void)
+ */
+
+void blur_pool_report(FILE *out)
+{
+	static char const *const names[] = {"float", "cores", "nodes"};
+	pool_policy_t policy = blur_pool_policy(NULL);
+	size_t n = blur_pool_size(), nranges, i, node;
+	int cpu;
+
+	blur_pool_pin(0, &nranges);
+	fprintf(out, "policy %s, %lu workers, jobs split in %lu ranges\n",
+		names[policy], (unsigned long)n, (unsigned long)nranges);
+	for (i = 0; i < n; i++)
+	{
+		cpu = blur_pool_cpu(i, &node);
+		if (cpu < 0)
+			fprintf(out, "worker %lu: floating\n",
+				(unsigned long)i);
+		else
+			fprintf(out, "worker %lu: cpu %d, node %lu%s\n",
+				(unsigned long)i, cpu, (unsigned long)node,
+				i ? "" : " (caller, not pinned)");
+	}
+}
@@ -0,0 +1,193 @@
+#include "multithreading.h"
+
+#define TAP_LO(pos, r) ((pos) < (r) ? (r) - (pos) : 0)
+#define TAP_HI(pos, r, size, limit) \
+	((limit) + (r) - (pos) < (size) ? (limit) + (r) - (pos) : (size))
+
+/**
+ * struct sep_pass_s - State shared by the two passes of a separable blur
+ * @portion: the portion of the image being blurred
+ * @row:     horizontal 1D kernel
+ * @col:     vertical 1D kernel
+ * @size:    number of taps of both 1D kernels
+ * @y0:      first source row covered by the intermediate buffer
+ * @y1:      row past the last source row covered by the intermediate buffer
+ * @xa:      first column whose horizontal taps all fall inside the image
+ * @xb:      column past the last column whose taps all fall inside the image
+ * @offs:    offset of every horizontal tap, for the convolution spans
+ * @tmp:     horizontally filtered rows, @portion->w RGB triplets each
+ * @acc:     one row of vertical accumulators, @portion->w RGB triplets
+ * @wsum:    per column sum of the in-bounds taps of @row
+ */
+
+typedef struct sep_pass_s
+{
+	blur_portion_t const *portion;
+	float const *row;
+	float const *col;
+	size_t size;
+	size_t y0;
+	size_t y1;
+	size_t xa;
+	size_t xb;
+	long *offs;
+	float *tmp;
+	float *acc;
+	float *wsum;
+} sep_pass_t;
+
+/**
+ * sep_cols_h - program that runs the horizontal pass over columns close
+ * to the left or right border of the image, skipping out-of-bounds taps
+ * @p: a pointer to the separable pass state
+ * @src: a pointer to the first pixel of the source row
+ * @from: the first column to filter
+ * @to: the column past the last column to filter
+ * @out: receives one RGB float triplet per column
+ * Return: nothing (void)
+ */
+
+static void sep_cols_h(sep_pass_t const *p, pixel_t const *src,
+		       size_t from, size_t to, float *out)
+{
+	size_t x, k, lo, hi, r = p->size / 2;
+	pixel_t const *px;
+
+	for (x = from; x < to; x++, out += 3)
+	{
+		lo = TAP_LO(x, r);
+		hi = TAP_HI(x, r, p->size, p->portion->img->w);
+		px = src + x + lo - r;
+		out[0] = out[1] = out[2] = 0;
+		for (k = lo; k < hi; k++, px++)
+		{
+			out[0] += px->r * p->row[k];
+			out[1] += px->g * p->row[k];
+			out[2] += px->b * p->row[k];
+		}
+	}
+}
+
+/**
+ * sep_pass_h - program that runs the horizontal pass of a separable blur
+ * every source row needed by the vertical pass is filtered once into the
+ * intermediate buffer; the columns whose taps all fall inside the image
+ * go through the vectorized convolution span, the others are handled one
+ * at a time; the weights are not normalized here
+ * @p: a pointer to the separable pass state
+ * Return: nothing (void)
+ */
+
+static void sep_pass_h(sep_pass_t const *p)
+{
+	blur_portion_t const *pt = p->portion;
+	size_t y, n = pt->w * 3;
+	pixel_t const *src;
+	float *out;
+
+	for (y = p->y0; y < p->y1; y++)
+	{
+		out = p->tmp + (y - p->y0) * n;
+		src = pt->img->pixels + y * pt->img->w;
+		sep_cols_h(p, src, pt->x, p->xa, out);
+		blur_conv_span(src + p->xa, p->offs, p->row, p->size,
+			       p->xb - p->xa, out + (p->xa - pt->x) * 3);
+		sep_cols_h(p, src, p->xb, pt->x + pt->w,
+			   out + (p->xb - pt->x) * 3);
+	}
+}
+
+/**
+ * sep_pass_v - program that runs the vertical pass of a separable blur
+ * each destination row is accumulated one source row at a time so the
+ * inner loop walks contiguous memory; the result is normalized by the
+ * product of the in-bounds row and column weights, which is exactly the
+ * in-bounds weight of the equivalent 2D kernel
+ * @p: a pointer to the separable pass state
+ * Return: nothing (void)
+ */
+
+static void sep_pass_v(sep_pass_t const *p)
+{
+	blur_portion_t const *pt = p->portion;
+	size_t x, y, k, i, lo, hi, r = p->size / 2, n = pt->w * 3;
+	float const *in;
+	float wc, norm;
+	pixel_t *dst;
+
+	for (y = pt->y; y < pt->y + pt->h; y++)
+	{
+		lo = TAP_LO(y, r);
+		hi = TAP_HI(y, r, p->size, pt->img->h);
+		for (i = 0; i < n; i++)
+			p->acc[i] = 0;
+		for (wc = 0, k = lo; k < hi; k++)
+		{
+			in = p->tmp + (y + k - r - p->y0) * n;
+			for (i = 0; i < n; i++)
+				p->acc[i] += p->col[k] * in[i];
+			wc += p->col[k];
+		}
+		dst = pt->img_blur->pixels + y * pt->img_blur->w + pt->x;
+		for (x = 0; x < pt->w; x++)
+		{
+			norm = wc * p->wsum[x];
+			dst[x].r = p->acc[x * 3] / norm;
+			dst[x].g = p->acc[x * 3 + 1] / norm;
+			dst[x].b = p->acc[x * 3 + 2] / norm;
+		}
+	}
+}
+
+/**
+ * blur_portion_separable - program that blurs a portion of an image with
+ * a separable kernel given as two explicit 1D kernels
+ * a horizontal pass filters every source row the portion depends on into
+ * an intermediate buffer, then a vertical pass combines those rows; the
+ * cost per pixel is O(2K) instead of the O(K^2) of the direct convolution,
+ * and pixels close to the image borders are renormalized exactly like the
+ * direct convolution does
+ * @portion: a pointer to the portion to blur; portion->kernel is not read
+ * @row: the horizontal 1D kernel
+ * @col: the vertical 1D kernel
+ * @size: the number of taps of both 1D kernels
+ * Return: 1 on success, 0 if the intermediate buffer could not be allocated
+ */
+
+int blur_portion_separable(blur_portion_t const *portion,
+			   float const *row, float const *col, size_t size)
+{
+	sep_pass_t p;
+	size_t k, i, r = size / 2, end = portion->y + portion->h + size - 1 - r;
+	size_t x1 = portion->x + portion->w, W = portion->img->w;
+
+	if (!portion->w || !portion->h)
+		return (1);
+	p.portion = portion, p.row = row, p.col = col, p.size = size;
+	p.y0 = portion->y > r ? portion->y - r : 0;
+	p.y1 = end < portion->img->h ? end : portion->img->h;
+	p.xa = portion->x > r ? portion->x : r;
+	p.xb = W > size - 1 - r ? W - (size - 1 - r) : 0;
+	p.xa = p.xa < x1 ? p.xa : x1;
+	p.xb = p.xb < x1 ? (p.xb > p.xa ? p.xb : p.xa) : x1;
+	p.offs = malloc(sizeof(long) * size + sizeof(float) * portion->w *
+			(3 * (p.y1 - p.y0 + 1) + 1));
+	if (!p.offs)
+		return (0);
+	p.tmp = (float *)(p.offs + size);
+	p.acc = p.tmp + (p.y1 - p.y0) * portion->w * 3;
+	p.wsum = p.acc + portion->w * 3;
+	for (k = 0; k < size; k++)
+		p.offs[k] = (long)k - (long)r;
+	for (k = 0; k < portion->w; k++)
+	{
+		p.wsum[k] = 0;
+		for (i = TAP_LO(portion->x + k, r);
+		     i < TAP_HI(portion->x + k, r, size, W); i++)
+			p.wsum[k] += row[i];
+	}
+	sep_pass_h(&p);
+	sep_pass_v(&p);
+	free(p.offs);
+	return (1);
+}
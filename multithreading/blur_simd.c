@@ -0,0 +1,139 @@
+#include "multithreading.h"
+
+#include <string.h>
+
+static simd_level_t simd_max = SIMD_SCALAR;
+static simd_level_t simd_level = SIMD_SCALAR;
+static conv_span_t conv_span_vec;
+
+/**
+ * conv_span_scalar - program that accumulates the taps of a kernel over a
+ * span of pixels, one output pixel at a time
+ * this is the reference implementation the vectorized spans must match;
+ * taps are accumulated in the order they are given, like blur_portion does
+ * @src: a pointer to the source pixel of the first output pixel
+ * @offs: the offset of every tap, in pixels, relative to the output pixel
+ * @w: the weight of every tap
+ * @ntaps: the number of taps
+ * @n: the number of output pixels of the span
+ * @acc: receives one RGB float triplet per output pixel
+ * Return: the number of output pixels processed, always n
+ */
+
+static size_t conv_span_scalar(pixel_t const *src, long const *offs,
+			       float const *w, size_t ntaps, size_t n,
+			       float *acc)
+{
+	pixel_t const *p;
+	size_t i, t;
+
+	for (i = 0; i < n; i++, acc += 3)
+	{
+		acc[0] = acc[1] = acc[2] = 0;
+		for (t = 0; t < ntaps; t++)
+		{
+			p = src + i + offs[t];
+			acc[0] += p->r * w[t];
+			acc[1] += p->g * w[t];
+			acc[2] += p->b * w[t];
+		}
+	}
+	return (n);
+}
+
+/**
+ * blur_simd_select - program that selects the instruction set used by the
+ * convolution spans
+ * the requested level is capped to what the CPU supports
+ * @level: the requested instruction set
+ * Return: the instruction set actually selected
+ */
+
+simd_level_t blur_simd_select(simd_level_t level)
+{
+	if (level > simd_max)
+		level = simd_max;
+	simd_level = level;
+	conv_span_vec = NULL;
+#if defined(__x86_64__) || defined(__i386__)
+	if (level == SIMD_SSE41)
+		conv_span_vec = conv_span_sse41;
+	else if (level == SIMD_AVX2)
+		conv_span_vec = conv_span_avx2;
+	else if (level == SIMD_AVX512)
+		conv_span_vec = conv_span_avx512;
+#endif
+	return (simd_level);
+}
+
+/**
+ * blur_simd_init - program that detects the instruction sets supported by
+ * the CPU and selects the widest one
+ * this function is marked with the constructor attribute, so the selection
+ * is made once at startup; the BLUR_SIMD environment variable (scalar,
+ * sse41, avx2 or avx512) may lower the selection
+ * Return: nothing (void)
+ */
+
+__attribute__((constructor))
+void blur_simd_init(void)
+{
+	char const *env = getenv("BLUR_SIMD");
+	simd_level_t level;
+
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse4.1"))
+		simd_max = SIMD_SSE41;
+	if (__builtin_cpu_supports("avx2"))
+		simd_max = SIMD_AVX2;
+	if (__builtin_cpu_supports("avx512f"))
+		simd_max = SIMD_AVX512;
+#endif
+	level = simd_max;
+	if (env && !strcmp(env, "scalar"))
+		level = SIMD_SCALAR;
+	else if (env && !strcmp(env, "sse41"))
+		level = SIMD_SSE41;
+	else if (env && !strcmp(env, "avx2"))
+		level = SIMD_AVX2;
+	else if (env && !strcmp(env, "avx512"))
+		level = SIMD_AVX512;
+	blur_simd_select(level);
+}
+
+/**
+ * blur_simd_level - program that reports the instruction set used by the
+ * convolution spans
+ * Return: the selected instruction set
+ */
+
+simd_level_t blur_simd_level(void)
+{
+	return (simd_level);
+}
+
+/**
+ * blur_conv_span - program that accumulates the taps of a kernel over a
+ * span of pixels with the selected instruction set
+ * every tap of every output pixel must fall inside the source image; the
+ * vectorized span handles as many output pixels as its width allows and
+ * the scalar reference finishes the tail
+ * @src: a pointer to the source pixel of the first output pixel
+ * @offs: the offset of every tap, in pixels, relative to the output pixel
+ * @w: the weight of every tap
+ * @ntaps: the number of taps
+ * @n: the number of output pixels of the span
+ * @acc: receives one RGB float triplet per output pixel
+ * Return: nothing (void)
+ */
+
+void blur_conv_span(pixel_t const *src, long const *offs, float const *w,
+		    size_t ntaps, size_t n, float *acc)
+{
+	size_t done = 0;
+
+	if (conv_span_vec)
+		done = conv_span_vec(src, offs, w, ntaps, n, acc);
+	conv_span_scalar(src + done, offs, w, ntaps, n - done, acc + done * 3);
+}
@@ -0,0 +1,199 @@
+#include "multithreading.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#define U8_PS128(v) _mm_cvtepi32_ps(_mm_cvtepu8_epi32(v))
+#define U8_PS256(v) _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v))
+#define U8_PS512(v) _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(v))
+#define MASK(a, b, c, d, e, f, g, h) \
+	_mm_setr_epi8(a, b, c, d, e, f, g, h, \
+		      -1, -1, -1, -1, -1, -1, -1, -1)
+
+/**
+ * deinterleave8 - program that loads 8 consecutive RGB pixels and splits
+ * them into one byte vector per channel
+ * exactly 24 bytes are read, so a span may end on the last pixel of the
+ * image; the 8 values of each channel land in the low half of the vectors
+ * @p: a pointer to the first of the 8 pixels
+ * @g: receives the green components
+ * @b: receives the blue components
+ * Return: the red components
+ */
+
+__attribute__((target("sse4.1")))
+static __m128i deinterleave8(pixel_t const *p, __m128i *g, __m128i *b)
+{
+	uint8_t const *bytes = (uint8_t const *)p;
+	__m128i lo = _mm_loadu_si128((__m128i const *)bytes);
+	__m128i hi = _mm_loadl_epi64((__m128i const *)(bytes + 16));
+
+	*g = _mm_or_si128(
+		_mm_shuffle_epi8(lo, MASK(1, 4, 7, 10, 13, -1, -1, -1)),
+		_mm_shuffle_epi8(hi, MASK(-1, -1, -1, -1, -1, 0, 3, 6)));
+	*b = _mm_or_si128(
+		_mm_shuffle_epi8(lo, MASK(2, 5, 8, 11, 14, -1, -1, -1)),
+		_mm_shuffle_epi8(hi, MASK(-1, -1, -1, -1, -1, 1, 4, 7)));
+	return (_mm_or_si128(
+		_mm_shuffle_epi8(lo, MASK(0, 3, 6, 9, 12, 15, -1, -1)),
+		_mm_shuffle_epi8(hi, MASK(-1, -1, -1, -1, -1, -1, 2, 5))));
+}
+
+/**
+ * store_rgb - program that interleaves planar channel accumulators back
+ * into RGB float triplets
+ * @acc: a pointer to the first triplet to write
+ * @planes: the red, green and blue accumulators, n floats each
+ * @n: the number of pixels to write
+ * Return: nothing (void)
+ */
+
+static void store_rgb(float *acc, float const *planes, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++, acc += 3)
+	{
+		acc[0] = planes[i];
+		acc[1] = planes[n + i];
+		acc[2] = planes[2 * n + i];
+	}
+}
+
+/**
+ * conv_span_sse41 - program that accumulates the taps of a kernel over a
+ * span of pixels, 8 output pixels per iteration with SSE4.1
+ * @src: a pointer to the source pixel of the first output pixel
+ * @offs: the offset of every tap, in pixels, relative to the output pixel
+ * @w: the weight of every tap
+ * @ntaps: the number of taps
+ * @n: the number of output pixels of the span
+ * @acc: receives one RGB float triplet per output pixel
+ * Return: the number of output pixels processed, a multiple of 8
+ */
+
+__attribute__((target("sse4.1")))
+size_t conv_span_sse41(pixel_t const *src, long const *offs, float const *w,
+		       size_t ntaps, size_t n, float *acc)
+{
+	float planes[24];
+	__m128 v[6], wt;
+	__m128i c[3], x;
+	size_t i, t, k;
+
+	for (i = 0; i + 8 <= n; i += 8)
+	{
+		for (k = 0; k < 6; k++)
+			v[k] = _mm_setzero_ps();
+		for (t = 0; t < ntaps; t++)
+		{
+			c[0] = deinterleave8(src + i + offs[t], c + 1, c + 2);
+			wt = _mm_set1_ps(w[t]);
+			for (k = 0; k < 3; k++)
+			{
+				x = _mm_srli_si128(c[k], 4);
+				v[2 * k] = _mm_add_ps(v[2 * k],
+					_mm_mul_ps(wt, U8_PS128(c[k])));
+				v[2 * k + 1] = _mm_add_ps(v[2 * k + 1],
+					_mm_mul_ps(wt, U8_PS128(x)));
+			}
+		}
+		for (k = 0; k < 6; k++)
+			_mm_storeu_ps(planes + 4 * k, v[k]);
+		store_rgb(acc + i * 3, planes, 8);
+	}
+	return (i);
+}
+
+/**
+ * conv_span_avx2 - program that accumulates the taps of a kernel over a
+ * span of pixels, 8 output pixels per iteration with AVX2
+ * @src: a pointer to the source pixel of the first output pixel
+ * @offs: the offset of every tap, in pixels, relative to the output pixel
+ * @w: the weight of every tap
+ * @ntaps: the number of taps
+ * @n: the number of output pixels of the span
+ * @acc: receives one RGB float triplet per output pixel
+ * Return: the number of output pixels processed, a multiple of 8
+ */
+
+__attribute__((target("avx2")))
+size_t conv_span_avx2(pixel_t const *src, long const *offs, float const *w,
+		      size_t ntaps, size_t n, float *acc)
+{
+	float planes[24];
+	__m256 v[3], wt;
+	__m128i c[3];
+	size_t i, t, k;
+
+	for (i = 0; i + 8 <= n; i += 8)
+	{
+		for (k = 0; k < 3; k++)
+			v[k] = _mm256_setzero_ps();
+		for (t = 0; t < ntaps; t++)
+		{
+			c[0] = deinterleave8(src + i + offs[t], c + 1, c + 2);
+			wt = _mm256_set1_ps(w[t]);
+			for (k = 0; k < 3; k++)
+				v[k] = _mm256_add_ps(v[k],
+					_mm256_mul_ps(wt, U8_PS256(c[k])));
+		}
+		for (k = 0; k < 3; k++)
+			_mm256_storeu_ps(planes + 8 * k, v[k]);
+		store_rgb(acc + i * 3, planes, 8);
+	}
+	return (i);
+}
+
+/**
+ * conv_span_avx512 - program that accumulates the taps of a kernel over a
+ * span of pixels, 16 output pixels per iteration with AVX-512
+ * @src: a pointer to the source pixel of the first output pixel
+ * @offs: the offset of every tap, in pixels, relative to the output pixel
+ * @w: the weight of every tap
+ * @ntaps: the number of taps
+ * @n: the number of output pixels of the span
+ * @acc: receives one RGB float triplet per output pixel
+ * Return: the number of output pixels processed, a multiple of 16
+ */
+
+__attribute__((target("avx512f")))
+size_t conv_span_avx512(pixel_t const *src, long const *offs, float const *w,
+			size_t ntaps, size_t n, float *acc)
+{
+	float planes[48];
+	__m512 v[3], wt;
+	__m128i lo[3], hi[3];
+	pixel_t const *p;
+	size_t i, t, k;
+
+	for (i = 0; i + 16 <= n; i += 16)
+	{
+		for (k = 0; k < 3; k++)
+			v[k] = _mm512_setzero_ps();
+		for (t = 0; t < ntaps; t++)
+		{
+			p = src + i + offs[t];
+			lo[0] = deinterleave8(p, lo + 1, lo + 2);
+			hi[0] = deinterleave8(p + 8, hi + 1, hi + 2);
+			wt = _mm512_set1_ps(w[t]);
+			for (k = 0; k < 3; k++)
+			{
+				lo[k] = _mm_unpacklo_epi64(lo[k], hi[k]);
+				v[k] = _mm512_add_ps(v[k],
+					_mm512_mul_ps(wt, U8_PS512(lo[k])));
+			}
+		}
+		for (k = 0; k < 3; k++)
+			_mm512_storeu_ps(planes + 16 * k, v[k]);
+		store_rgb(acc + i * 3, planes, 16);
+	}
+	return (i);
+}
+
+#else
+
+typedef int blur_simd_x86_unused_t;
+
+#endif /* __x86_64__ || __i386__ */
@@ -0,0 +1,72 @@
+#include "multithreading.h"
+
+/**
+ * struct stencil_job_s - Argument of the pool job running a stencil
+ * @tiles:  the tiles of the image
+ * @st:     the filter
+ * @failed: set once a tile could not be filtered
+ */
+
+typedef struct stencil_job_s
+{
+	blur_portion_t const *tiles;
+	stencil_t const *st;
+	int failed;
+} stencil_job_t;
+
+/**
+ * stencil_job - pool job program that runs a filter over one tile of an
+ * image
+ * @arg: a pointer to the stencil_job_t describing the job
+ * @i: the index of the tile
+ * Return: nothing (void)
+ */
+
+static void stencil_job(void *arg, size_t i)
+{
+	stencil_job_t *job = arg;
+
+	if (!job->st->portion(job->tiles + i, job->st->ctx))
+		__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * blur_stencil - program that runs a filter over an entire image using
+ * multithreading
+ * the image is divided into the cache-sized 2D tiles of portionTiles,
+ * sized for the footprint of the filter, which the workers of the blur
+ * pool pull one at a time; every tile carries the edge mode of opts and
+ * is handed to the portion program of the filter, which reads img and
+ * writes img_blur within the tile only; the filter fails if the portion
+ * program fails on any tile
+ * @img_blur: a pointer to the output image data structure
+ * @img: a pointer to the input image data structure
+ * @st: a pointer to the filter
+ * @opts: a pointer to the blur options, NULL for the defaults; planar and
+ *        fixed are left to the filter
+ * Return: 1 on success, 0 on failure
+ */
+
+int blur_stencil(img_t *img_blur, img_t const *img, stencil_t const *st,
+		 blur_opts_t const *opts)
+{
+	blur_opts_t defaults = {EDGE_RENORMALIZE, 0, 0, 0, 0};
+	stencil_job_t job;
+	kernel_t view;
+	size_t count = 0;
+
+	if (!img->w || !img->h)
+		return (1);
+	view.size = st->size, view.matrix = NULL;
+	job.tiles = portionTiles(img_blur, img, st->kernel ? st->kernel : &view,
+				 opts ? opts : &defaults, &count);
+	if (!job.tiles)
+	{
+		fprintf(stderr, "blur_stencil: portionTiles failed\n");
+		return (0);
+	}
+	job.st = st, job.failed = 0;
+	blur_pool_run(count, stencil_job, &job);
+	free((void *)job.tiles);
+	return (!job.failed);
+}
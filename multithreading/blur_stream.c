@@ -0,0 +1,244 @@
+#include "multithreading.h"
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PPM_HEADER_MAX 512
+#define STREAM_BAND_BYTES (32 * 1024 * 1024)
+
+/**
+ * struct stream_s - State of a banded blur of an image file
+ * @in:       descriptor of the source file
+ * @out:      descriptor of the destination file
+ * @in_data:  offset of the first pixel in the source file
+ * @out_data: offset of the first pixel in the destination file
+ * @w:        width of the image
+ * @h:        height of the image
+ * @band:     number of rows blurred per band
+ * @ck:       compiled kernel
+ * @opts:     blur options
+ * @src:      source band, halo rows included
+ * @dst:      destination band, halo rows included
+ */
+
+typedef struct stream_s
+{
+	int in;
+	int out;
+	off_t in_data;
+	off_t out_data;
+	size_t w;
+	size_t h;
+	size_t band;
+	ckernel_t *ck;
+	blur_opts_t const *opts;
+	img_t src;
+	img_t dst;
+} stream_t;
+
+/**
+ * ppm_header - program that parses the header of a binary PPM (P6) image
+ * with 8-bit samples
+ * @fd: the descriptor of the image file
+ * @w: receives the width of the image
+ * @h: receives the height of the image
+ * @data: receives the offset of the first pixel
+ * Return: 1 on success, 0 if the file is not an 8-bit binary PPM
+ */
+
+static int ppm_header(int fd, size_t *w, size_t *h, off_t *data)
+{
+	char buf[PPM_HEADER_MAX + 1], *end;
+	ssize_t n = pread(fd, buf, PPM_HEADER_MAX, 0);
+	unsigned long v[3];
+	ssize_t pos = 2;
+	int i;
+
+	if (n < 3 || buf[0] != 'P' || buf[1] != '6')
+		return (0);
+	buf[n] = 0;
+	for (i = 0; i < 3; i++)
+	{
+		while (pos < n && (isspace((unsigned char)buf[pos]) ||
+				   buf[pos] == '#'))
+			while (buf[pos++] == '#')
+				while (pos < n && buf[pos] != '\n')
+					pos++;
+		if (pos >= n || !isdigit((unsigned char)buf[pos]))
+			return (0);
+		v[i] = strtoul(buf + pos, &end, 10);
+		pos = end - buf;
+	}
+	if (pos >= n || !isspace((unsigned char)buf[pos]) || v[2] != 255 ||
+	    !v[0] || !v[1])
+		return (0);
+	*w = v[0], *h = v[1], *data = pos + 1;
+	return (1);
+}
+
+/**
+ * stream_io - program that reads or writes a run of consecutive rows of
+ * an image file, retrying on short transfers
+ * @fd: the descriptor of the image file
+ * @rows: the buffer the rows are read into or written from
+ * @bytes: the number of bytes to transfer
+ * @off: the offset of the first byte in the file
+ * @write: 1 to write the rows, 0 to read them
+ * Return: 1 on success, 0 on failure
+ */
+
+static int stream_io(int fd, void *rows, size_t bytes, off_t off, int write)
+{
+	uint8_t *p = rows;
+	ssize_t n;
+
+	while (bytes)
+	{
+		if (write)
+			n = pwrite(fd, p, bytes, off);
+		else
+			n = pread(fd, p, bytes, off);
+		if (n <= 0 && (n == 0 || errno != EINTR))
+			return (0);
+		if (n <= 0)
+			continue;
+		p += n, bytes -= n, off += n;
+	}
+	return (1);
+}
+
+/**
+ * stream_band - program that blurs one band of rows of an image file
+ * the band is read with a halo of kernel rows above and below it, fetched
+ * through the edge mode at the top and bottom of the image (and dropped
+ * with EDGE_RENORMALIZE), so that its rows blur exactly like they do in
+ * the whole image; runs of consecutive rows are read in one call
+ * @s: a pointer to the stream state
+ * @y0: the first row of the band
+ * @y1: the row past the last row of the band
+ * Return: 1 on success, 0 on failure
+ */
+
+static int stream_band(stream_t *s, size_t y0, size_t y1)
+{
+	long r = (long)s->ck->size / 2, t = (long)s->ck->size - 1 - r;
+	long lo = (long)y0 - r, hi = (long)(y1 + t), i, j;
+	size_t row = s->w * sizeof(pixel_t), src;
+	edge_mode_t mode = s->opts->edge;
+
+	if (mode == EDGE_RENORMALIZE)
+	{
+		lo = lo < 0 ? 0 : lo;
+		hi = hi > (long)s->h ? (long)s->h : hi;
+	}
+	s->src.h = s->dst.h = hi - lo;
+	for (i = lo; i < hi; i = j)
+	{
+		src = edge_index(i, s->h, mode);
+		for (j = i + 1; j < hi && edge_index(j, s->h, mode) ==
+			     src + (j - i); j++)
+			;
+		if (!stream_io(s->in, s->src.pixels + (i - lo) * s->w,
+			       (j - i) * row, s->in_data + src * row, 0))
+			return (0);
+	}
+	if (!blur_image_ck(&s->dst, &s->src, s->ck, s->opts))
+		return (0);
+	return (stream_io(s->out, s->dst.pixels + (y0 - lo) * s->w,
+			  (y1 - y0) * row, s->out_data + y0 * row, 1));
+}
+
+/**
+ * stream_temp - program that creates the temporary file a blurred image
+ * is written to, next to its final path, so that it is renamed into place
+ * only once complete
+ * @path: the final path of the image
+ * @fd: a pointer receiving the descriptor of the file, -1 on failure
+ * Return: the path of the temporary file, to be released with free, or
+ *         NULL on failure
+ */
+
+static char *stream_temp(char const *path, int *fd)
+{
+	char *tmp = malloc(strlen(path) + sizeof(".XXXXXX"));
+
+	*fd = -1;
+	if (!tmp)
+		return (NULL);
+	sprintf(tmp, "%s.XXXXXX", path);
+	*fd = mkstemp(tmp);
+	if (*fd < 0 || fchmod(*fd, 0644))
+	{
+		if (*fd >= 0)
+			close(*fd), unlink(tmp);
+		free(tmp);
+		*fd = -1;
+		return (NULL);
+	}
+	return (tmp);
+}
+
+/**
+ * blur_file - program that blurs a binary PPM image file band by band,
+ * without ever holding the whole image in memory
+ * bands of rows are read with pread, blurred on the blur pool and written
+ * with pwrite as soon as they are done, so the peak memory is two bands
+ * grown by the kernel halo, whatever the size of the image; the image is
+ * written to a temporary file renamed over out_path once complete, so a
+ * failure leaves an existing out_path as it was, and out_path may be
+ * in_path
+ * @out_path: the path of the blurred PPM image to write
+ * @in_path: the path of the 8-bit binary PPM (P6) image to blur
+ * @kernel: a pointer to the convolution kernel
+ * @opts: a pointer to the blur options, NULL for the defaults
+ * @band: the number of rows per band, 0 to size the bands to about
+ *        STREAM_BAND_BYTES
+ * Return: 1 on success, 0 on failure
+ */
+
+int blur_file(char const *out_path, char const *in_path,
+	      kernel_t const *kernel, blur_opts_t const *opts, size_t band)
+{
+	blur_opts_t defaults = {EDGE_RENORMALIZE, 0, 0, 0, 0};
+	stream_t s;
+	size_t y, rows;
+	char *tmp = NULL;
+	int ok = 0;
+
+	s.opts = opts ? opts : &defaults;
+	s.in = open(in_path, O_RDONLY), s.out = -1;
+	s.ck = kernel_compile(kernel);
+	s.src.pixels = s.dst.pixels = NULL;
+	if (s.in >= 0 && s.ck && ppm_header(s.in, &s.w, &s.h, &s.in_data) &&
+	    (tmp = stream_temp(out_path, &s.out)))
+	{
+		s.band = band ? band : STREAM_BAND_BYTES / (s.w * 3) + 1;
+		s.band = s.band < s.h ? s.band : s.h;
+		s.src.w = s.dst.w = s.w;
+		rows = s.band + s.ck->size - 1;
+		s.src.pixels = malloc(sizeof(pixel_t) * s.w * 2 * rows);
+		s.dst.pixels = s.src.pixels ? s.src.pixels + s.w * rows : NULL;
+		s.out_data = dprintf(s.out, "P6\n%lu %lu\n255\n",
+				     (unsigned long)s.w, (unsigned long)s.h);
+		ok = s.src.pixels && s.out_data > 0;
+		for (y = 0; ok && y < s.h; y += s.band)
+			ok = stream_band(&s, y, y + s.band < s.h ?
+					 y + s.band : s.h);
+	}
+	free(s.src.pixels);
+	kernel_free(s.ck);
+	if (s.in >= 0)
+		close(s.in);
+	if (s.out >= 0 && close(s.out))
+		ok = 0;
+	if (tmp && (!ok || rename(tmp, out_path)))
+		ok = 0, unlink(tmp);
+	free(tmp);
+	if (!ok)
+		fprintf(stderr, "blur_file: cannot blur %s into %s\n",
+			in_path, out_path);
+	return (ok);
+}
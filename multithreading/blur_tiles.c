@@ -0,0 +1,172 @@
+#include "multithreading.h"
+
+#include <unistd.h>
+
+#define TILE_L2_DEFAULT (256 * 1024)
+#define TILE_MIN_W 64
+#define TILE_ALIGN_W 16
+#define TILE_PER_WORKER 4
+
+/**
+ * struct tiles_conv_s - Convolution run by the stencil engine
+ * @ck:    the compiled kernel
+ * @fixed: whether to convolve in fixed point
+ */
+
+typedef struct tiles_conv_s
+{
+	ckernel_t const *ck;
+	int fixed;
+} tiles_conv_t;
+
+/**
+ * blur_tile_size - program that picks the size of the tiles an image is
+ * split into, so that the working set of a tile fits in half of the L2
+ * cache
+ * the working set of a tile is its source rectangle grown by the kernel
+ * halo, the float intermediate rows of the separable path and the
+ * destination rectangle; tiles are short enough to give every worker
+ * several tiles to balance the load, but always at least as tall as the
+ * kernel, or as the image if it is shorter, so the halo rows do not
+ * dominate
+ * @w: the width of the image
+ * @h: the height of the image
+ * @ksize: the size of the kernel
+ * @tw: receives the width of the tiles
+ * @th: receives the height of the tiles
+ * Return: nothing (void)
+ */
+
+void blur_tile_size(size_t w, size_t h, size_t ksize, size_t *tw, size_t *th)
+{
+	long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+	size_t budget = (l2 > 0 ? (size_t)l2 : TILE_L2_DEFAULT) / 2;
+	size_t per_col, rows, cols, want = TILE_PER_WORKER * blur_pool_size();
+
+	rows = 2 * ksize > 32 ? 2 * ksize : 32;
+	per_col = (rows + ksize - 1) * (sizeof(pixel_t) + 3 * sizeof(float)) +
+		  rows * sizeof(pixel_t);
+	*tw = budget / per_col;
+	*tw = *tw < TILE_MIN_W ? TILE_MIN_W : *tw - *tw % TILE_ALIGN_W;
+	*tw = *tw < w ? *tw : w;
+	per_col = *tw * (sizeof(pixel_t) + 3 * sizeof(float));
+	*th = budget / per_col > ksize - 1 ? budget / per_col - (ksize - 1) : 1;
+	*th = *th < ksize ? ksize : *th;
+	cols = (w + *tw - 1) / *tw;
+	if (cols * ((h + *th - 1) / *th) < want)
+		*th = h * cols / want;
+	*th = *th < ksize ? ksize : *th;
+	*th = *th < 1 ? 1 : (*th < h ? *th : h);
+	*tw = *tw < 1 ? 1 : *tw;
+}
+
+/**
+ * portionTiles - program that divides an image into 2D tiles for
+ * parallel processing
+ * the tiles are laid out in row-major order, so that tiles handed out
+ * consecutively share their halo rows in the cache; the tiles on the
+ * right and bottom edges are cropped to the image
+ * @img_blur: the output image structure where the blurred image
+ *            will be stored
+ * @img: the input image structure to be blurred
+ * @kernel: the convolution kernel used for blurring
+ * @opts: the blur options; tile_w and tile_h of 0 select blur_tile_size
+ * @count: receives the number of tiles
+ * Return: a pointer to an array of blur_portion_t structures,
+ *         each representing a tile of the image, or NULL on failure
+ */
+
+blur_portion_t *portionTiles(img_t *img_blur, img_t const *img,
+			     kernel_t const *kernel, blur_opts_t const *opts,
+			     size_t *count)
+{
+	blur_portion_t *tiles;
+	size_t tw = opts->tile_w, th = opts->tile_h, cols, rows, i, x, y;
+
+	if (!img->w || !img->h)
+		return (NULL);
+	if (!tw || !th)
+	{
+		blur_tile_size(img->w, img->h, kernel->size, &cols, &rows);
+		tw = tw ? tw : cols;
+		th = th ? th : rows;
+	}
+	cols = (img->w + tw - 1) / tw;
+	rows = (img->h + th - 1) / th;
+	*count = cols * rows;
+	tiles = malloc(sizeof(blur_portion_t) * *count);
+	if (!tiles)
+		return (NULL);
+	for (i = 0; i < *count; i++)
+	{
+		tiles[i].img = img;
+		tiles[i].img_blur = img_blur;
+		tiles[i].x = x = (i % cols) * tw;
+		tiles[i].y = y = (i / cols) * th;
+		tiles[i].w = img->w - x < tw ? img->w - x : tw;
+		tiles[i].h = img->h - y < th ? img->h - y : th;
+		tiles[i].kernel = kernel;
+		tiles[i].edge = opts->edge;
+	}
+	return (tiles);
+}
+
+/**
+ * tiles_conv - stencil program that blurs one tile of an image with the
+ * edge mode it carries, in fixed point if the convolution asks for it
+ * @tile: a pointer to the tile to blur
+ * @ctx: a pointer to the tiles_conv_t describing the convolution
+ * Return: always 1
+ */
+
+static int tiles_conv(blur_portion_t const *tile, void const *ctx)
+{
+	tiles_conv_t const *conv = ctx;
+
+	if (conv->fixed)
+		blur_portion_fixed(tile, conv->ck, tile->edge);
+	else
+		blur_portion_ck_edge(tile, conv->ck, tile->edge);
+	return (1);
+}
+
+/**
+ * blur_image_ck - program that blurs an entire image with a compiled
+ * kernel using multithreading
+ * the image is divided into cache-sized 2D tiles which the workers of the
+ * long-lived blur pool pull one at a time from a shared atomic counter,
+ * so that workers finishing early keep taking tiles until none is left,
+ * the convolution being run as a filter of the stencil engine;
+ * with opts->planar set the image goes through blur_image_planar instead,
+ * and kernels cheaper to convolve in the frequency domain (see
+ * kernel_fft_size) go through blur_image_fft; either falls back to the
+ * tiles if it fails
+ * @img_blur: a pointer to the output image data structure
+ * @img: a pointer to the input image data structure
+ * @ck: a pointer to the compiled kernel
+ * @opts: a pointer to the blur options, NULL for the defaults
+ * Return: 1 on success, 0 on failure
+ */
+
+int blur_image_ck(img_t *img_blur, img_t const *img, ckernel_t const *ck,
+		  blur_opts_t const *opts)
+{
+	blur_opts_t defaults = {EDGE_RENORMALIZE, 0, 0, 0, 0};
+	tiles_conv_t conv;
+	stencil_t st;
+
+	if (!img_blur || !img || !ck || !img_blur->pixels || !img->pixels)
+		return (0);
+	if (!img->w || !img->h)
+		return (1);
+	opts = opts ? opts : &defaults;
+	if (opts->planar && opts->edge == EDGE_RENORMALIZE &&
+	    blur_image_planar(img_blur, img, ck, opts))
+		return (1);
+	if (kernel_fft_size(ck) && blur_image_fft(img_blur, img, ck, opts))
+		return (1);
+	conv.ck = ck, conv.fixed = opts->fixed;
+	st.size = ck->size, st.kernel = &ck->kernel;
+	st.portion = tiles_conv, st.ctx = &conv;
+	return (blur_stencil(img_blur, img, &st, opts));
+}
@@ -0,0 +1,190 @@
+#include "multithreading.h"
+
+#include <time.h>
+
+#define TUNE_REPS 2
+#define TUNE_NTILES 4
+
+/**
+ * struct tune_call_s - Call of blur_image_tuned being tuned
+ * @dst:    the output image
+ * @src:    the input image
+ * @kernel: the convolution kernel
+ * @edge:   the edge mode
+ * @fixed:  whether the fixed-point backend, which is not exact, may be
+ *          picked
+ * @best:   the fastest configuration so far, ms < 0 if there is none yet
+ */
+
+typedef struct tune_call_s
+{
+	fimg_t *dst;
+	fimg_t const *src;
+	kernel_t const *kernel;
+	edge_mode_t edge;
+	int fixed;
+	tune_t best;
+} tune_call_t;
+
+static size_t const tune_tiles[TUNE_NTILES][2] = {
+	{64, 64}, {128, 32}, {256, 16}, {512, 64}
+};
+static pthread_mutex_t tune_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * tune_class - program that gives the size class of an image, the images
+ * of a class having the same number of bits in their pixel count, i.e.
+ * being within a factor of two of each other
+ * @w: the width of the image
+ * @h: the height of the image
+ * Return: the size class
+ */
+
+size_t tune_class(size_t w, size_t h)
+{
+	size_t n = w * h, bits = 0;
+
+	for (; n; n >>= 1)
+		bits++;
+	return (bits);
+}
+
+/**
+ * tune_run - program that blurs an image with a configuration
+ * the blur jobs of the call are limited to the thread count of the
+ * configuration (see blur_pool_limit), the pool itself is left as it is
+ * @call: a pointer to the call
+ * @t: a pointer to the configuration
+ * Return: the time of the call in milliseconds, or -1 on failure
+ */
+
+static double tune_run(tune_call_t const *call, tune_t const *t)
+{
+	blur_opts_t opts = {EDGE_RENORMALIZE, 0, 0, 0, 0};
+	struct timespec t0, t1;
+	size_t prev;
+	int ok;
+
+	opts.edge = call->edge;
+	opts.tile_w = t->tile_w, opts.tile_h = t->tile_h;
+	opts.fixed = t->backend == TUNE_FIXED;
+	opts.planar = t->backend == TUNE_PLANAR;
+	prev = blur_pool_limit(t->threads);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	ok = blur_image_format(call->dst, call->src, call->kernel, &opts);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	blur_pool_limit(prev);
+	if (!ok)
+		return (-1);
+	return ((t1.tv_sec - t0.tv_sec) * 1e3 +
+		(t1.tv_nsec - t0.tv_nsec) / 1e6);
+}
+
+/**
+ * tune_try - program that times a candidate configuration and keeps it
+ * if it beats the fastest one so far
+ * the fastest of TUNE_REPS calls is kept, the first one warming the
+ * caches up
+ * @call: a pointer to the call being tuned
+ * @t: a pointer to the candidate, whose ms is overwritten
+ * Return: 1 if the candidate is the new fastest configuration, 0 otherwise
+ */
+
+static int tune_try(tune_call_t *call, tune_t *t)
+{
+	double ms;
+	size_t i;
+
+	for (i = 0, t->ms = -1; i < TUNE_REPS; i++)
+	{
+		ms = tune_run(call, t);
+		if (ms < 0)
+			return (0);
+		t->ms = t->ms < 0 || ms < t->ms ? ms : t->ms;
+	}
+	if (call->best.ms >= 0 && t->ms >= call->best.ms)
+		return (0);
+	call->best = *t;
+	return (1);
+}
+
+/**
+ * tune_search - program that looks for the fastest configuration of a
+ * call, one parameter at a time
+ * the backends are timed with automatic tiles on every blur worker, then
+ * the fixed tile sizes with the fastest backend, then the thread count is
+ * halved as long as it gets faster; the planar and fixed-point
+ * backends only exist for PIXEL_RGB8, and the fixed-point one is only
+ * tried if the caller accepts it
+ * @call: a pointer to the call, whose best receives the configuration
+ * Return: nothing (void)
+ */
+
+static void tune_search(tune_call_t *call)
+{
+	tune_t t = call->best;
+	size_t i, nbackends = t.format == PIXEL_RGB8 ? 3 : 1;
+
+	t.tile_w = t.tile_h = 0;
+	t.threads = blur_pool_size();
+	for (i = 0; i < nbackends; i++)
+	{
+		t.backend = (tune_backend_t)i;
+		if (t.backend != TUNE_FIXED || call->fixed)
+			tune_try(call, &t);
+	}
+	for (i = 0, t = call->best; i < TUNE_NTILES; i++)
+	{
+		t.tile_w = tune_tiles[i][0], t.tile_h = tune_tiles[i][1];
+		tune_try(call, &t);
+	}
+	for (t = call->best, t.threads /= 2; t.threads; t.threads /= 2)
+		if (!tune_try(call, &t))
+			break;
+}
+
+/**
+ * blur_image_tuned - program that blurs an entire image with the fastest
+ * configuration known for its size class, kernel size and pixel format
+ * the first call of a class on a host times candidate configurations (see
+ * tune_search), remembers the fastest one and saves it to the cache file
+ * (see tune_store); the later calls, in this process or the next ones,
+ * use it right away; the blur jobs of the call use the thread count of
+ * the configuration, without resizing the blur pool for the other callers;
+ * only the searches are serialized, the calls of a class already tuned
+ * never wait for the search of another class; a fixed-point configuration
+ * is run in float by the callers that do not accept it
+ * @img_blur: a pointer to the output image, of the size and format of img
+ * @img: a pointer to the input image
+ * @kernel: a pointer to the convolution kernel
+ * @edge: the edge mode
+ * @fixed: whether the fixed-point backend, which may be one level off the
+ *         float ones (see blur_portion_fixed), may be picked
+ * Return: 1 on success, 0 on failure
+ */
+
+int blur_image_tuned(fimg_t *img_blur, fimg_t const *img,
+		     kernel_t const *kernel, edge_mode_t edge, int fixed)
+{
+	tune_call_t call;
+
+	call.dst = img_blur, call.src = img, call.kernel = kernel;
+	call.edge = edge, call.fixed = fixed;
+	call.best.size_class = tune_class(img->w, img->h);
+	call.best.ksize = kernel->size, call.best.format = img->format;
+	call.best.ms = -1;
+	if (!tune_lookup(&call.best))
+	{
+		pthread_mutex_lock(&tune_lock);
+		if (!tune_lookup(&call.best))
+		{
+			tune_search(&call);
+			if (call.best.ms >= 0)
+				tune_store(&call.best);
+		}
+		pthread_mutex_unlock(&tune_lock);
+	}
+	if (call.best.backend == TUNE_FIXED && !fixed)
+		call.best.backend = TUNE_FLOAT;
+	return (call.best.ms >= 0 && tune_run(&call, &call.best) >= 0);
+}
@@ -0,0 +1,153 @@
+#include "multithreading.h"
+
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TUNE_MAX_ENTRIES 256
+#define TUNE_HEADER "# blur_tune: class ksize format backend tile_w tile_h " \
+	"threads ms\n"
+
+/**
+ * struct tune_cache_s - Configurations picked by the auto-tuner
+ * @lock:    protects the fields below
+ * @entries: the configurations, one per size class, kernel size and format
+ * @n:       the number of configurations
+ * @path:    the cache file, empty if the configurations are not saved
+ */
+
+static struct tune_cache_s
+{
+	pthread_mutex_t lock;
+	tune_t entries[TUNE_MAX_ENTRIES];
+	size_t n;
+	char path[PATH_MAX];
+} cache = {PTHREAD_MUTEX_INITIALIZER, {{0, 0, 0, 0, 0, 0, 0, 0}}, 0, ""};
+
+/**
+ * tune_put - program that records a configuration, replacing the one of
+ * the same size class, kernel size and format; the caller holds the lock
+ * @t: a pointer to the configuration
+ * Return: nothing (void)
+ */
+
+static void tune_put(tune_t const *t)
+{
+	size_t i;
+
+	for (i = 0; i < cache.n; i++)
+		if (cache.entries[i].size_class == t->size_class &&
+		    cache.entries[i].ksize == t->ksize &&
+		    cache.entries[i].format == t->format)
+			break;
+	if (i == TUNE_MAX_ENTRIES)
+		return;
+	cache.entries[i] = *t;
+	cache.n += i == cache.n;
+}
+
+/**
+ * tune_load - program that loads the configurations of the cache file
+ * this function is marked with the constructor attribute, so the file is
+ * read once at startup; the BLUR_TUNE_CACHE environment variable names
+ * the file, an empty value disabling the cache, and defaults to
+ * ~/.blur_tune.<hostname>; a line that does not parse is skipped, a later
+ * line overriding an earlier one
+ * Return: nothing (void)
+ */
+
+__attribute__((constructor))
+static void tune_load(void)
+{
+	char const *env = getenv("BLUR_TUNE_CACHE"), *home = getenv("HOME");
+	char host[64] = "", line[256];
+	unsigned long v[5];
+	int fmt, backend;
+	tune_t t;
+	FILE *f;
+
+	if (env && strlen(env) < PATH_MAX)
+		strcpy(cache.path, env);
+	else if (!env && home && strlen(home) + 80 < PATH_MAX)
+	{
+		gethostname(host, sizeof(host) - 1);
+		sprintf(cache.path, "%s/.blur_tune.%s", home, host);
+	}
+	f = cache.path[0] ? fopen(cache.path, "r") : NULL;
+	while (f && fgets(line, sizeof(line), f))
+	{
+		if (sscanf(line, "%lu %lu %d %d %lu %lu %lu %lf", v, v + 1,
+			   &fmt, &backend, v + 2, v + 3, v + 4, &t.ms) != 8 ||
+		    fmt < PIXEL_RGB8 || fmt > PIXEL_RGBF || backend < 0 ||
+		    backend > TUNE_PLANAR || !v[4] || t.ms < 0)
+			continue;
+		t.size_class = v[0], t.ksize = v[1], t.tile_w = v[2];
+		t.tile_h = v[3], t.threads = v[4];
+		t.format = (pixel_format_t)fmt;
+		t.backend = (tune_backend_t)backend;
+		tune_put(&t);
+	}
+	if (f)
+		fclose(f);
+}
+
+/**
+ * tune_lookup - program that finds the configuration picked for a class
+ * of calls
+ * @tune: a pointer to the configuration, whose size_class, ksize and
+ *        format are set; the other fields are filled if it is found
+ * Return: 1 if the configuration is found, 0 otherwise
+ */
+
+int tune_lookup(tune_t *tune)
+{
+	size_t i;
+	int found = 0;
+
+	pthread_mutex_lock(&cache.lock);
+	for (i = 0; !found && i < cache.n; i++)
+		if (cache.entries[i].size_class == tune->size_class &&
+		    cache.entries[i].ksize == tune->ksize &&
+		    cache.entries[i].format == tune->format)
+		{
+			*tune = cache.entries[i];
+			found = 1;
+		}
+	pthread_mutex_unlock(&cache.lock);
+	return (found);
+}
+
+/**
+ * tune_store - program that records the configuration picked for a class
+ * of calls and appends it to the cache file
+ * the stream is flushed once, in append mode, so processes tuning at the
+ * same time do not interleave their lines; a failure to write the file is
+ * reported and otherwise ignored
+ * @tune: a pointer to the configuration
+ * Return: nothing (void)
+ */
+
+void tune_store(tune_t const *tune)
+{
+	FILE *f;
+	char line[256];
+	int ok;
+
+	pthread_mutex_lock(&cache.lock);
+	tune_put(tune);
+	f = cache.path[0] ? fopen(cache.path, "a") : NULL;
+	if (f && !ftell(f))
+		fputs(TUNE_HEADER, f);
+	sprintf(line, "%lu %lu %d %d %lu %lu %lu %.3f\n",
+		(unsigned long)tune->size_class, (unsigned long)tune->ksize,
+		(int)tune->format, (int)tune->backend,
+		(unsigned long)tune->tile_w, (unsigned long)tune->tile_h,
+		(unsigned long)tune->threads, tune->ms);
+	ok = f && fputs(line, f) >= 0;
+	if (f && fclose(f))
+		ok = 0;
+	if (cache.path[0] && !ok)
+		fprintf(stderr, "blur_image_tuned: cannot write %s\n",
+			cache.path);
+	pthread_mutex_unlock(&cache.lock);
+}
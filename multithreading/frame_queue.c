@@ -0,0 +1,75 @@
+#include "multithreading.h"
+
+/**
+ * frame_queue_init - program that initializes an empty frame queue
+ * @q: a pointer to the queue
+ * @cap: the capacity of the queue
+ * Return: 1 on success, 0 on failure
+ */
+
+int frame_queue_init(frame_queue_t *q, size_t cap)
+{
+	q->slots = malloc(sizeof(frame_t *) * cap);
+	if (!q->slots)
+		return (0);
+	q->cap = cap, q->head = 0, q->len = 0;
+	pthread_mutex_init(&q->lock, NULL);
+	pthread_cond_init(&q->nonempty, NULL);
+	pthread_cond_init(&q->nonfull, NULL);
+	return (1);
+}
+
+/**
+ * frame_queue_destroy - program that releases the resources of a frame
+ * queue, but not the frames it may still hold
+ * @q: a pointer to the queue
+ * Return: nothing (void)
+ */
+
+void frame_queue_destroy(frame_queue_t *q)
+{
+	free(q->slots);
+	q->slots = NULL;
+	pthread_mutex_destroy(&q->lock);
+	pthread_cond_destroy(&q->nonempty);
+	pthread_cond_destroy(&q->nonfull);
+}
+
+/**
+ * frame_queue_push - program that appends a frame to a queue, waiting for
+ * room if the queue is full
+ * @q: a pointer to the queue
+ * @frame: the frame, NULL to mark the end of the stream
+ * Return: nothing (void)
+ */
+
+void frame_queue_push(frame_queue_t *q, frame_t *frame)
+{
+	pthread_mutex_lock(&q->lock);
+	while (q->len == q->cap)
+		pthread_cond_wait(&q->nonfull, &q->lock);
+	q->slots[(q->head + q->len++) % q->cap] = frame;
+	pthread_cond_signal(&q->nonempty);
+	pthread_mutex_unlock(&q->lock);
+}
+
+/**
+ * frame_queue_pop - program that removes the oldest frame of a queue,
+ * waiting for one if the queue is empty
+ * @q: a pointer to the queue
+ * Return: the frame, NULL at the end of the stream
+ */
+
+frame_t *frame_queue_pop(frame_queue_t *q)
+{
+	frame_t *frame;
+
+	pthread_mutex_lock(&q->lock);
+	while (!q->len)
+		pthread_cond_wait(&q->nonempty, &q->lock);
+	frame = q->slots[q->head];
+	q->head = (q->head + 1) % q->cap, q->len--;
+	pthread_cond_signal(&q->nonfull);
+	pthread_mutex_unlock(&q->lock);
+	return (frame);
+}
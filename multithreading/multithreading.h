@@ -54,6 +54,93 @@ typedef struct kernel_s
     float **matrix;
 } kernel_t;
 
+/**
+ * enum edge_mode_e - Behaviors of the blur at the borders of the image
+ * @EDGE_RENORMALIZE: Out-of-bounds taps are dropped and the weights of the
+ *                    remaining taps renormalized
+ * @EDGE_CLAMP:       Out-of-bounds taps read the closest border pixel
+ * @EDGE_MIRROR:      Out-of-bounds taps read the image mirrored at its
+ *                    borders, border pixels included
+ * @EDGE_WRAP:        Out-of-bounds taps read the image tiled periodically
+ */
+
+typedef enum edge_mode_e
+{
+    EDGE_RENORMALIZE = 0,
+    EDGE_CLAMP,
+    EDGE_MIRROR,
+    EDGE_WRAP
+} edge_mode_t;
+
+#define KERNEL_SYM_H 1
+#define KERNEL_SYM_V 2
+#define KERNEL_SYM_D 4
+
+/**
+ * struct fft_s - Radix-2 2D FFT of a fixed size, with the spectrum of a
+ *                kernel, see kernel_fft
+ * @n:   Size of the transform along both axes, a power of two
+ * @m:   Size of the output tiles, n - kernel size + 1
+ * @cos: cos(2 pi k / n) for every k below n / 2
+ * @sin: sin(2 pi k / n) for every k below n / 2
+ * @kre: Real part of the spectrum of the mirrored kernel, n * n row-major
+ * @kim: Imaginary part of the spectrum of the mirrored kernel
+ * @sat: Summed-area table of the kernel weights, (size + 1)^2 row-major
+ */
+
+typedef struct fft_s
+{
+    size_t n;
+    size_t m;
+    double *cos;
+    double *sin;
+    double *kre;
+    double *kim;
+    double *sat;
+} fft_t;
+
+/**
+ * struct ckernel_s - Compiled convolution kernel, see kernel_compile
+ * @size:      Size of the kernel (both width and height)
+ * @weights:   Weights, row-major, in one 64-byte aligned contiguous array
+ * @sum:       Sum of all the weights, accumulated in row-major order
+ * @separable: Whether the kernel is the outer product of @col and @row
+ * @row:       Horizontal factor of a separable kernel
+ * @col:       Vertical factor of a separable kernel
+ * @sym:       Symmetries of the kernel: KERNEL_SYM_H (left-right),
+ *             KERNEL_SYM_V (top-bottom), KERNEL_SYM_D (transpose)
+ * @ntaps:     Number of non-zero taps
+ * @tap_x:     Column offset of every non-zero tap from the output pixel
+ * @tap_y:     Row offset of every non-zero tap from the output pixel
+ * @tap_w:     Weight of every non-zero tap
+ * @tap_q:     Weight of every non-zero tap in fixed point, see
+ *             kernel_quantize; the weights add up to 1 << @qshift
+ * @qshift:    Number of fractional bits of @tap_q, 0 if the kernel could
+ *             not be quantized
+ * @fft:       Spectrum of the kernel, built on first use by blur_image_fft
+ *             and kept as long as the compiled kernel
+ * @kernel:    kernel_t view whose rows point into @weights
+ */
+
+typedef struct ckernel_s
+{
+    size_t size;
+    float *weights;
+    float sum;
+    int separable;
+    float *row;
+    float *col;
+    int sym;
+    size_t ntaps;
+    long *tap_x;
+    long *tap_y;
+    float *tap_w;
+    int16_t *tap_q;
+    int qshift;
+    fft_t *fft;
+    kernel_t kernel;
+} ckernel_t;
+
 /**
  * struct blur_portion_s - Information needed to blur a portion of an image
  * @img:      Source image
@@ -63,6 +150,8 @@ typedef struct kernel_s
  * @w:        Width of the portion
  * @h:        Height of the portion
  * @kernel:   Convolution kernel to use
+ * @edge:     Edge mode, honored by blur_portion_edge and blur_image_edge;
+ *            blur_portion itself always renormalizes
  */
 
 typedef struct blur_portion_s
@@ -74,8 +163,315 @@ typedef struct blur_portion_s
     size_t w;
     size_t h;
     kernel_t const *kernel;
+    edge_mode_t edge;
 } blur_portion_t;
 
+/**
+ * enum simd_level_e - Instruction sets of the convolution spans
+ * @SIMD_SCALAR: Portable scalar reference
+ * @SIMD_SSE41:  SSE4.1, 8 output pixels per iteration
+ * @SIMD_AVX2:   AVX2, 8 output pixels per iteration
+ * @SIMD_AVX512: AVX-512F, 16 output pixels per iteration
+ */
+
+typedef enum simd_level_e
+{
+    SIMD_SCALAR = 0,
+    SIMD_SSE41,
+    SIMD_AVX2,
+    SIMD_AVX512
+} simd_level_t;
+
+typedef size_t (*conv_span_t)(pixel_t const *, long const *, float const *,
+			      size_t, size_t, float *);
+
+typedef void (*pool_job_t)(void *arg, size_t i);
+
+#define POOL_MAX_NODES 64
+
+/**
+ * enum pool_policy_e - Placement of the blur workers, see blur_pool_policy
+ * @POOL_FLOAT: Workers are not pinned, the scheduler may migrate them
+ * @POOL_CORES: Worker i is pinned to the i-th processor the process may
+ *              run on
+ * @POOL_NODES: Workers are pinned to processors of the NUMA nodes in turn,
+ *              and every job is split into one contiguous range of items
+ *              per node
+ */
+
+typedef enum pool_policy_e
+{
+    POOL_FLOAT = 0,
+    POOL_CORES,
+    POOL_NODES
+} pool_policy_t;
+
+/**
+ * struct pool_ranges_s - Items of a pool job, split into contiguous ranges
+ *                        handed out by separate atomic counters
+ * @next:  Next item of every range to hand out
+ * @end:   Item past the last item of every range
+ * @n:     Number of ranges
+ * @count: Number of items of the job
+ */
+
+typedef struct pool_ranges_s
+{
+    size_t next[POOL_MAX_NODES];
+    size_t end[POOL_MAX_NODES];
+    size_t n;
+    size_t count;
+} pool_ranges_t;
+
+/**
+ * struct blur_opts_s - Options of blur_image_opts; a zero-initialized
+ *                      structure selects the defaults
+ * @edge:   Edge mode
+ * @tile_w: Width of the tiles the image is split into, 0 for automatic
+ * @tile_h: Height of the tiles the image is split into, 0 for automatic
+ * @planar: Whether to blur through the planar layout, see blur_planar;
+ *          ignored for the edge modes the planar path does not support
+ * @fixed:  Whether to convolve in 16-bit fixed point, see
+ *          blur_portion_fixed; ignored by the planar path
+ */
+
+typedef struct blur_opts_s
+{
+    edge_mode_t edge;
+    size_t tile_w;
+    size_t tile_h;
+    int planar;
+    int fixed;
+} blur_opts_t;
+
+/**
+ * struct planar_s - Image stored as three separate channel planes
+ * @w:      Image width
+ * @h:      Image height
+ * @stride: Distance in bytes between two rows of a plane, a multiple of 64
+ * @planes: Red, green and blue planes, 64-byte aligned, in one block
+ */
+
+typedef struct planar_s
+{
+    size_t w;
+    size_t h;
+    size_t stride;
+    uint8_t *planes[3];
+} planar_t;
+
+/**
+ * struct rect_s - Rectangle of pixels of an image
+ * @x: Left column
+ * @y: Top row
+ * @w: Width
+ * @h: Height
+ */
+
+typedef struct rect_s
+{
+    size_t x;
+    size_t y;
+    size_t w;
+    size_t h;
+} rect_t;
+
+/**
+ * enum pixel_format_e - Sample layouts of the images of blur_image_format
+ * @PIXEL_RGB8:  Three uint8_t samples, the layout of pixel_t
+ * @PIXEL_RGBA8: Four uint8_t samples, alpha blurred like the colors
+ * @PIXEL_RGB16: Three uint16_t samples
+ * @PIXEL_RGBF:  Three float samples, unbounded (HDR)
+ */
+
+typedef enum pixel_format_e
+{
+    PIXEL_RGB8 = 0,
+    PIXEL_RGBA8,
+    PIXEL_RGB16,
+    PIXEL_RGBF
+} pixel_format_t;
+
+/**
+ * struct fimg_s - Image of any pixel format
+ * @w:      Image width
+ * @h:      Image height
+ * @format: Layout of the pixels
+ * @pixels: Array of pixels, row-major without padding
+ */
+
+typedef struct fimg_s
+{
+    size_t w;
+    size_t h;
+    pixel_format_t format;
+    void *pixels;
+} fimg_t;
+
+/**
+ * enum tune_backend_e - Backends tried by the auto-tuner
+ * @TUNE_FLOAT:  Tiles convolved in float, see blur_image_opts
+ * @TUNE_FIXED:  Tiles convolved in 16-bit fixed point, only picked for the
+ *               callers that accept it
+ * @TUNE_PLANAR: Planar layout, see blur_image_planar
+ */
+
+typedef enum tune_backend_e
+{
+    TUNE_FLOAT = 0,
+    TUNE_FIXED,
+    TUNE_PLANAR
+} tune_backend_t;
+
+/**
+ * struct tune_s - Configuration picked by the auto-tuner for a class of
+ *                 calls, see blur_image_tuned
+ * @size_class: Number of bits of the pixel count of the images
+ * @ksize:      Size of the kernel
+ * @format:     Pixel format of the images
+ * @backend:    Backend
+ * @tile_w:     Width of the tiles, 0 for automatic
+ * @tile_h:     Height of the tiles, 0 for automatic
+ * @threads:    Number of blur workers
+ * @ms:         Time of a call when the configuration was picked, in
+ *              milliseconds
+ */
+
+typedef struct tune_s
+{
+    size_t size_class;
+    size_t ksize;
+    pixel_format_t format;
+    tune_backend_t backend;
+    size_t tile_w;
+    size_t tile_h;
+    size_t threads;
+    double ms;
+} tune_t;
+
+typedef int (*stencil_portion_t)(blur_portion_t const *tile,
+				 void const *ctx);
+
+/**
+ * struct stencil_s - Filter run over an image by blur_stencil
+ * @size:    Size of the square footprint of the filter, like a kernel size
+ * @kernel:  Kernel carried by the tiles, NULL to carry a kernel_t of
+ *           @size without a matrix
+ * @portion: Filters one tile of the image; the pixels of the footprint
+ *           falling outside of the image are handled with tile->edge;
+ *           returns 0 if the tile could not be filtered, 1 otherwise
+ * @ctx:     Data of the filter, passed to @portion
+ */
+
+typedef struct stencil_s
+{
+    size_t size;
+    kernel_t const *kernel;
+    stencil_portion_t portion;
+    void const *ctx;
+} stencil_t;
+
+/**
+ * struct bilateral_s - Weights of a bilateral filter, see blur_bilateral
+ * @radius: Radius of the footprint
+ * @space:  Spatial weight of every tap of the footprint, row-major
+ * @offs:   Offset of every tap of the footprint, in pixels, relative to
+ *          the output pixel, in the image filtered
+ * @range:  Range weight of every color distance, the distance being the
+ *          sum of the absolute differences of the three channels
+ */
+
+typedef struct bilateral_s
+{
+    size_t radius;
+    float *space;
+    long *offs;
+    float range[3 * 255 + 1];
+} bilateral_t;
+
+#define PYRAMID_MAX_LEVELS 32
+
+/**
+ * struct pyramid_s - Gaussian pyramid of an image, see pyramid_create
+ * @nlevels: Number of levels built so far, the image itself included
+ * @levels:  Levels of the pyramid; level 0 shares the pixels of the image,
+ *           level k + 1 is level k blurred with the 5-tap binomial filter
+ *           and decimated by two along both axes
+ */
+
+typedef struct pyramid_s
+{
+    size_t nlevels;
+    img_t levels[PYRAMID_MAX_LEVELS];
+} pyramid_t;
+
+/**
+ * struct frame_s - Frame of a batch, see blur_batch
+ * @img:   Image of the frame, its pixels owned by the batch
+ * @index: Position of the frame in the batch
+ */
+
+typedef struct frame_s
+{
+    img_t img;
+    size_t index;
+} frame_t;
+
+/**
+ * struct frame_queue_s - Bounded blocking FIFO of frames
+ * @lock:     protects the fields below
+ * @nonempty: signaled when a frame is pushed
+ * @nonfull:  signaled when a frame is popped
+ * @slots:    ring buffer of @cap frames; a NULL frame marks the end of a
+ *            stream
+ * @cap:      capacity of the queue
+ * @head:     index of the oldest frame
+ * @len:      number of frames in the queue
+ */
+
+typedef struct frame_queue_s
+{
+    pthread_mutex_t lock;
+    pthread_cond_t nonempty;
+    pthread_cond_t nonfull;
+    frame_t **slots;
+    size_t cap;
+    size_t head;
+    size_t len;
+} frame_queue_t;
+
+typedef int (*frame_load_t)(void *ctx, size_t index, img_t *img);
+typedef int (*frame_store_t)(void *ctx, size_t index, img_t const *img);
+
+/**
+ * struct blur_batch_s - Batch of frames of the same size to blur, see
+ *                       blur_batch
+ * @count:  Number of frames
+ * @w:      Width of every frame
+ * @h:      Height of every frame
+ * @kernel: Convolution kernel
+ * @opts:   Blur options, NULL for the defaults
+ * @load:   Fills the pixels of a frame, returns 0 on failure; called in
+ *          order of index from the load thread
+ * @store:  Consumes a blurred frame, returns 0 on failure; called in order
+ *          of index from the store thread
+ * @ctx:    Passed to @load and @store
+ * @depth:  Number of frames buffered between two stages, 0 for a default
+ */
+
+typedef struct blur_batch_s
+{
+    size_t count;
+    size_t w;
+    size_t h;
+    kernel_t const *kernel;
+    blur_opts_t const *opts;
+    frame_load_t load;
+    frame_store_t store;
+    void *ctx;
+    size_t depth;
+} blur_batch_t;
+
 /* task 6 - 22-prime_factors.c */
 
 typedef void *(*task_entry_t)(void *);
@@ -103,6 +499,13 @@ typedef enum task_status_e
  * @status: the current status of the task, represented by task_status_t
  * @result: a pointer to store the result of the task execution
  * @lock: mutex to ensure thread-safety of task modifications
+ * @futex: futex word of the threads waiting for the task: 0 while it runs,
+ *         2 once some thread sleeps on it, 1 once it completed
+ * @deps: number of predecessors left to complete, plus one until the task
+ *        is submitted (see task_depend)
+ * @npred: number of predecessors, @deps being reset from it at every run
+ * @succ: successors of the task, released as it completes
+ * @nsucc: number of successors
  */
 
 typedef struct task_s
@@ -112,8 +515,95 @@ typedef struct task_s
     task_status_t   status;
     void           *result;
     pthread_mutex_t lock;
+    unsigned int    futex;
+    size_t          deps;
+    size_t          npred;
+    struct task_s **succ;
+    size_t          nsucc;
 } task_t;
 
+/**
+ * struct task_ring_s - Circular array of the slots of a task deque
+ * @size:  Number of slots, a power of two
+ * @slots: Slots, the task of index i living in slot i & (size - 1)
+ * @prev:  Array this one replaced when the deque grew, kept until the
+ *         deque is freed since a thief may still be reading it
+ */
+
+typedef struct task_ring_s
+{
+    size_t size;
+    task_t **slots;
+    struct task_ring_s *prev;
+} task_ring_t;
+
+/**
+ * struct task_deque_s - Chase-Lev work-stealing deque of tasks; its owner
+ *                       pushes and pops at the bottom, the other threads
+ *                       steal from the top
+ * @top:    Index of the oldest task
+ * @bottom: Index past the newest task
+ * @ring:   Slots of the tasks, NULL until the first push
+ */
+
+typedef struct task_deque_s
+{
+    long top;
+    long bottom;
+    task_ring_t *ring;
+} task_deque_t;
+
+/**
+ * struct task_worker_s - Worker thread of a work-stealing scheduler
+ * @deque:  Tasks submitted by the tasks this worker runs
+ * @sched:  Scheduler of the worker
+ * @id:     Index of the worker in the scheduler
+ * @victim: Index of the next worker to steal from
+ * @thread: Thread of the worker
+ */
+
+typedef struct task_worker_s
+{
+    task_deque_t deque;
+    struct task_sched_s *sched;
+    size_t id;
+    size_t victim;
+    pthread_t thread;
+} task_worker_t;
+
+/**
+ * struct task_sched_s - Work-stealing scheduler of tasks
+ * @workers:    Workers, one deque each
+ * @nworkers:   Number of workers
+ * @started:    Number of worker threads actually created
+ * @inbox:      Tasks submitted from threads that are not workers, pushed
+ *              under inbox_lock and stolen without it
+ * @inbox_lock: Serializes the pushes to the inbox
+ * @lock:       Protects the sleeping on @wake
+ * @wake:       Signaled when a task is submitted while some thread is
+ *              asleep, broadcast when a task is completed while some
+ *              thread waits for one, or when the scheduler stops
+ * @epoch:      Incremented every time @wake is signaled or broadcast
+ * @sleepers:   Number of threads looking for work before going to sleep
+ * @waiters:    Number of these threads that wait for a task
+ * @stop:       Set to have the workers exit once out of work
+ */
+
+typedef struct task_sched_s
+{
+    task_worker_t *workers;
+    size_t nworkers;
+    size_t started;
+    task_deque_t inbox;
+    pthread_mutex_t inbox_lock;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    unsigned long epoch;
+    size_t sleepers;
+    size_t waiters;
+    int stop;
+} task_sched_t;
+
 /* -------------------------------------------------------------------------- */
 
 /* task 0 */
@@ -124,12 +614,178 @@ int tprintf(char const *format, ...);
 
 /* task 2 */
 void blur_portion(blur_portion_t const *portion);
+void blur_portion_ck(blur_portion_t const *portion, ckernel_t const *ck);
 
 /* task 3 */
 void *blurPortionThreadEntry(blur_portion_t *portion);
 blur_portion_t *portionImage(img_t *img_blur, const img_t *img,
 			     const kernel_t *kernel, size_t portion_ct);
 void blur_image(img_t *img_blur, img_t const *img, kernel_t const *kernel);
+void blur_image_edge(img_t *img_blur, img_t const *img,
+		     kernel_t const *kernel, edge_mode_t mode);
+void blur_image_opts(img_t *img_blur, img_t const *img,
+		     kernel_t const *kernel, blur_opts_t const *opts);
+
+/* compiled kernels - blur_kernel.c, blur_kernel_cache.c */
+int kernel_separate(kernel_t const *kernel, float *row, float *col);
+ckernel_t *kernel_compile(kernel_t const *kernel);
+void kernel_free(ckernel_t *ck);
+ckernel_t const *kernel_cached(kernel_t const *kernel);
+
+/* separable blur - blur_separable.c */
+int blur_portion_separable(blur_portion_t const *portion,
+			   float const *row, float const *col, size_t size);
+
+/* blur worker pool - blur_pool.c, blur_pool_limit.c */
+size_t blur_pool_init(size_t nthreads);
+void blur_pool_shutdown(void);
+size_t blur_pool_size(void);
+void blur_pool_run(size_t count, pool_job_t fn, void *arg);
+size_t blur_pool_limit(size_t nthreads);
+size_t pool_job_limit(size_t nthreads);
+
+/* worker placement - blur_affinity.c, blur_ranges.c */
+pool_policy_t blur_pool_policy(pool_policy_t const *policy);
+int blur_pool_cpu(size_t worker, size_t *node);
+size_t blur_pool_pin(size_t worker, size_t *nranges);
+void blur_pool_report(FILE *out);
+void pool_ranges_split(pool_ranges_t *r, size_t count, size_t n);
+size_t pool_ranges_claim(pool_ranges_t *r, size_t home);
+int blur_image_alloc(img_t *img, size_t w, size_t h);
+
+/* cache-blocked tiles - blur_tiles.c */
+void blur_tile_size(size_t w, size_t h, size_t ksize, size_t *tw, size_t *th);
+blur_portion_t *portionTiles(img_t *img_blur, img_t const *img,
+			     kernel_t const *kernel, blur_opts_t const *opts,
+			     size_t *count);
+int blur_image_ck(img_t *img_blur, img_t const *img, ckernel_t const *ck,
+		  blur_opts_t const *opts);
+
+/* stencil engine - blur_stencil.c, blur_median.c, blur_bilateral.c */
+int blur_stencil(img_t *img_blur, img_t const *img, stencil_t const *st,
+		 blur_opts_t const *opts);
+int blur_median(img_t *img_blur, img_t const *img, size_t radius,
+		blur_opts_t const *opts);
+int blur_bilateral(img_t *img_blur, img_t const *img, size_t radius,
+		   float sigma_s, float sigma_r, blur_opts_t const *opts);
+
+/* edge modes - blur_edge.c */
+size_t edge_index(long i, size_t n, edge_mode_t mode);
+void blur_portion_ck_edge(blur_portion_t const *portion, ckernel_t const *ck,
+			  edge_mode_t mode);
+void blur_portion_edge(blur_portion_t const *portion, edge_mode_t mode);
+
+/* SIMD convolution spans - blur_simd.c, blur_simd_x86.c */
+simd_level_t blur_simd_select(simd_level_t level);
+void blur_simd_init(void);
+simd_level_t blur_simd_level(void);
+void blur_conv_span(pixel_t const *src, long const *offs, float const *w,
+		    size_t ntaps, size_t n, float *acc);
+#if defined(__x86_64__) || defined(__i386__)
+size_t conv_span_sse41(pixel_t const *src, long const *offs, float const *w,
+		       size_t ntaps, size_t n, float *acc);
+size_t conv_span_avx2(pixel_t const *src, long const *offs, float const *w,
+		      size_t ntaps, size_t n, float *acc);
+size_t conv_span_avx512(pixel_t const *src, long const *offs, float const *w,
+			size_t ntaps, size_t n, float *acc);
+#endif
+
+/* planar layout - blur_planar*.c */
+planar_t *planar_create(size_t w, size_t h);
+void planar_free(planar_t *planar);
+void planar_from_img(planar_t *planar, img_t const *img);
+void planar_to_img(img_t *img, planar_t const *planar);
+int blur_image_planar(img_t *img_blur, img_t const *img, ckernel_t const *ck,
+		      blur_opts_t const *opts);
+int blur_planar(planar_t *dst, planar_t const *src, ckernel_t const *ck,
+		blur_opts_t const *opts);
+void planar_row_madd_u8(float *acc, uint8_t const *s, float w, size_t n);
+void planar_row_madd_f32(float *acc, float const *s, float w, size_t n);
+#if defined(__x86_64__) || defined(__i386__)
+size_t planar_unpack_ssse3(pixel_t const *src, uint8_t *const planes[3],
+			   size_t n);
+size_t planar_pack_ssse3(uint8_t const *const planes[3], pixel_t *dst,
+			 size_t n);
+size_t planar_madd_u8_avx2(float *acc, uint8_t const *s, float w, size_t n);
+size_t planar_madd_f32_avx2(float *acc, float const *s, float w, size_t n);
+#endif
+
+/* box blur - blur_box.c */
+int blur_box(img_t *img_blur, img_t const *img, size_t radius,
+	     edge_mode_t mode);
+int blur_box_gauss(img_t *img_blur, img_t const *img, float sigma,
+		   edge_mode_t mode);
+
+/* out-of-core blur - blur_stream.c */
+int blur_file(char const *out_path, char const *in_path,
+	      kernel_t const *kernel, blur_opts_t const *opts, size_t band);
+
+/* in-place blur - blur_inplace.c */
+int blur_image_inplace(img_t *img, kernel_t const *kernel,
+		       blur_opts_t const *opts);
+
+/* batched frames - blur_batch.c, frame_queue.c */
+int frame_queue_init(frame_queue_t *q, size_t cap);
+void frame_queue_destroy(frame_queue_t *q);
+void frame_queue_push(frame_queue_t *q, frame_t *frame);
+frame_t *frame_queue_pop(frame_queue_t *q);
+int blur_batch(blur_batch_t const *batch);
+
+/* FFT convolution - blur_fft.c, blur_fft_conv.c */
+void fft_transform(fft_t const *f, double *re, double *im, size_t stride,
+		   size_t count, int inverse);
+size_t kernel_fft_size(ckernel_t const *ck);
+fft_t *kernel_fft(ckernel_t const *ck, size_t n);
+void fft_free(fft_t *f);
+int blur_image_fft(img_t *img_blur, img_t const *img, ckernel_t const *ck,
+		   blur_opts_t const *opts);
+
+/* incremental blur - blur_dirty.c */
+size_t dirty_expand(rect_t const *dirty, img_t const *img, size_t ksize,
+		    edge_mode_t mode, rect_t *out);
+size_t dirty_merge(rect_t *rects, size_t count);
+int blur_image_dirty(img_t *img_blur, img_t const *img,
+		     kernel_t const *kernel, blur_opts_t const *opts,
+		     rect_t const *dirty, size_t count);
+
+/* pixel formats - blur_format_image.c */
+size_t pixel_format_size(pixel_format_t format);
+int blur_image_format(fimg_t *img_blur, fimg_t const *img,
+		      kernel_t const *kernel, blur_opts_t const *opts);
+
+/* auto-tuner - blur_tune.c, blur_tune_cache.c */
+size_t tune_class(size_t w, size_t h);
+int blur_image_tuned(fimg_t *img_blur, fimg_t const *img,
+		     kernel_t const *kernel, edge_mode_t edge, int fixed);
+int tune_lookup(tune_t *tune);
+void tune_store(tune_t const *tune);
+
+/* fused pipeline - blur_pipeline.c */
+int blur_pipeline(img_t *img_blur, img_t const *img,
+		  kernel_t const *const *kernels, size_t nstages,
+		  blur_opts_t const *opts);
+
+/* Gaussian pyramid - blur_pyramid.c, blur_pyramid_up.c */
+pyramid_t *pyramid_create(img_t const *img);
+img_t const *pyramid_level(pyramid_t *pyr, size_t level);
+void pyramid_free(pyramid_t *pyr);
+int blur_pyramid(img_t *img_blur, pyramid_t *pyr, float sigma,
+		 blur_opts_t const *opts);
+
+/* fixed-point convolution - blur_fixed.c, blur_fixed_x86.c */
+void kernel_quantize(ckernel_t *ck);
+int portion_interior(blur_portion_t const *portion, size_t size,
+		     blur_portion_t *in, blur_portion_t s[4]);
+void blur_portion_fixed(blur_portion_t const *portion, ckernel_t const *ck,
+			edge_mode_t mode);
+#if defined(__x86_64__) || defined(__i386__)
+size_t fixed_span_sse41(uint8_t const *src, long const *offs,
+			int16_t const *q, size_t ntaps, int shift, size_t n,
+			uint8_t *dst);
+size_t fixed_span_avx2(uint8_t const *src, long const *offs,
+		       int16_t const *q, size_t ntaps, int shift, size_t n,
+		       uint8_t *dst);
+#endif
 
 /* task 4 */
 void init_mutex(void);
@@ -148,4 +804,31 @@ task_t *create_task(task_entry_t entry, void *param);
 void destroy_task(task_t *task);
 void *exec_tasks(list_t const *tasks);
 
+/* work-stealing deques - task_deque.c */
+int task_deque_push(task_deque_t *dq, task_t *task);
+task_t *task_deque_pop(task_deque_t *dq);
+task_t *task_deque_steal(task_deque_t *dq);
+void task_deque_free(task_deque_t *dq);
+
+/* work-stealing scheduler - task_sched.c, task_steal.c, task_dag.c */
+task_sched_t *task_sched_create(size_t nworkers);
+void task_sched_destroy(task_sched_t *sched);
+void task_sched_wake(task_sched_t *sched, int completed);
+void task_sched_run(task_sched_t *sched, task_t *task);
+int task_sched_idle(task_sched_t *sched, task_t const *waited);
+void *task_sched_worker(void *arg);
+int task_sched_push(task_sched_t *sched, task_t *task);
+void *task_wait(task_sched_t *sched, task_t *task);
+int task_depend(task_t *task, task_t *pred);
+int task_submit(task_sched_t *sched, task_t *task);
+void task_sched_release(task_sched_t *sched, task_t *task);
+
+/* task futures - task_future.c, task_future_get.c */
+void future_complete(task_t *task, void *result);
+int future_timedwait(task_t *task, long timeout_ms, void **result);
+long future_wait_any(task_t *const *tasks, size_t n, long timeout_ms);
+void *future_wait(task_t *task);
+int future_try_get(task_t const *task, void **result);
+int future_wait_all(task_t *const *tasks, size_t n, long timeout_ms);
+
 #endif /* MULTITHREADING_H */
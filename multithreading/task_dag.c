@@ -0,0 +1,77 @@
+#include "multithreading.h"
+
+/**
+ * task_depend - program that makes a task wait for another one to
+ * complete before it runs
+ * both tasks must not be submitted yet, so the graph of a pipeline is
+ * built first and submitted as a whole, in any order; a task runs once
+ * it is submitted and its last predecessor completed, whether it succeeded
+ * or failed, and may read the result of its predecessors; the graph can
+ * be submitted again once it completed; the dependencies are honoured by
+ * the work-stealing scheduler only
+ * @task: a pointer to the task
+ * @pred: a pointer to the task it waits for
+ * Return: 1 on success, 0 on failure
+ */
+
+int task_depend(task_t *task, task_t *pred)
+{
+	task_t **succ;
+
+	if (!task || !pred || task == pred)
+		return (0);
+	succ = realloc(pred->succ, sizeof(task_t *) * (pred->nsucc + 1));
+	if (!succ)
+	{
+		fprintf(stderr, "task_depend: out of memory\n");
+		return (0);
+	}
+	pred->succ = succ;
+	pred->succ[pred->nsucc++] = task;
+	task->deps++, task->npred++;
+	return (1);
+}
+
+/**
+ * task_submit - program that submits a task to a work-stealing scheduler
+ * the task is queued right away if all of its predecessors completed,
+ * and by the last of them to complete otherwise (see task_sched_release);
+ * a task may only be submitted once at a time
+ * @sched: a pointer to the scheduler
+ * @task: a pointer to the task, as made by create_task
+ * Return: 1 on success, 0 on failure
+ */
+
+int task_submit(task_sched_t *sched, task_t *task)
+{
+	if (!sched || !task)
+		return (0);
+	task->result = NULL, task->futex = 0;
+	__atomic_store_n(&task->status, PENDING, __ATOMIC_RELAXED);
+	if (__atomic_sub_fetch(&task->deps, 1, __ATOMIC_ACQ_REL))
+		return (1);
+	return (task_sched_push(sched, task));
+}
+
+/**
+ * task_sched_release - program that releases the successors of a task
+ * that completed
+ * the count of predecessors left of every successor is decremented, and
+ * the successor brought to zero, whose submission counts as one, is
+ * queued at once on the deque of the worker that ran the task; the
+ * independent branches of a graph thus run as soon as their inputs are
+ * ready, without any barrier between stages
+ * @sched: a pointer to the scheduler
+ * @task: a pointer to the task
+ * Return: nothing (void)
+ */
+
+void task_sched_release(task_sched_t *sched, task_t *task)
+{
+	size_t i;
+
+	for (i = 0; i < task->nsucc; i++)
+		if (!__atomic_sub_fetch(&task->succ[i]->deps, 1,
+					__ATOMIC_ACQ_REL))
+			task_sched_push(sched, task->succ[i]);
+}
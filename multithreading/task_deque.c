@@ -0,0 +1,148 @@
+#include "multithreading.h"
+
+#define TASK_RING_MIN 64
+
+/**
+ * task_deque_grow - program that replaces the slots of a deque with an
+ * array twice as large, or creates its first one
+ * the tasks keep their indices, so a thief that read top before the swap
+ * finds the same task in either array; the old array is chained to the
+ * new one rather than freed
+ * @dq: a pointer to the deque, only called by its owner
+ * @top: the top index read by the owner
+ * @bottom: the bottom index
+ * Return: a pointer to the new array, or NULL on failure
+ */
+
+static task_ring_t *task_deque_grow(task_deque_t *dq, long top, long bottom)
+{
+	task_ring_t *old = dq->ring, *ring;
+	size_t size = old ? 2 * old->size : TASK_RING_MIN;
+	long i;
+
+	ring = malloc(sizeof(task_ring_t) + size * sizeof(task_t *));
+	if (!ring)
+	{
+		fprintf(stderr, "task_deque_push: out of memory\n");
+		return (NULL);
+	}
+	ring->size = size, ring->prev = old;
+	ring->slots = (task_t **)(ring + 1);
+	for (i = top; i < bottom; i++)
+		ring->slots[i & (size - 1)] =
+			__atomic_load_n(old->slots + (i & (old->size - 1)),
+					__ATOMIC_RELAXED);
+	__atomic_store_n(&dq->ring, ring, __ATOMIC_RELEASE);
+	return (ring);
+}
+
+/**
+ * task_deque_push - program that pushes a task at the bottom of a deque
+ * only the owner of the deque may push; the slot is written before the
+ * bottom index is published with release semantics, so a thief that sees
+ * the new bottom sees the task
+ * @dq: a pointer to the deque
+ * @task: a pointer to the task
+ * Return: 1 on success, 0 on failure
+ */
+
+int task_deque_push(task_deque_t *dq, task_t *task)
+{
+	long b = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED);
+	long t = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE);
+	task_ring_t *ring = dq->ring;
+
+	if (!ring || b - t >= (long)ring->size)
+		ring = task_deque_grow(dq, t, b);
+	if (!ring)
+		return (0);
+	__atomic_store_n(ring->slots + (b & (ring->size - 1)), task,
+			 __ATOMIC_RELAXED);
+	__atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELEASE);
+	return (1);
+}
+
+/**
+ * task_deque_pop - program that takes the newest task of a deque
+ * only the owner of the deque may pop; the bottom index is lowered before
+ * top is read, with a full fence in between, so the owner and a thief can
+ * only both want the last task, which they then race for on top
+ * @dq: a pointer to the deque
+ * Return: a pointer to the task, or NULL if the deque is empty
+ */
+
+task_t *task_deque_pop(task_deque_t *dq)
+{
+	long b = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED) - 1, t;
+	task_ring_t *ring = dq->ring;
+	task_t *task;
+
+	__atomic_store_n(&dq->bottom, b, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	t = __atomic_load_n(&dq->top, __ATOMIC_RELAXED);
+	if (t > b)
+	{
+		__atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+		return (NULL);
+	}
+	task = __atomic_load_n(ring->slots + (b & (ring->size - 1)),
+			       __ATOMIC_RELAXED);
+	if (t == b)
+	{
+		if (!__atomic_compare_exchange_n(&dq->top, &t, t + 1, 0,
+						 __ATOMIC_SEQ_CST,
+						 __ATOMIC_RELAXED))
+			task = NULL;
+		__atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+	}
+	return (task);
+}
+
+/**
+ * task_deque_steal - program that takes the oldest task of a deque
+ * any thread may steal; the task is read before top is moved past it with
+ * a compare-and-swap, which fails if the owner or another thief took it
+ * first
+ * @dq: a pointer to the deque
+ * Return: a pointer to the task, or NULL if the deque is empty or the
+ *         task was lost to another thread
+ */
+
+task_t *task_deque_steal(task_deque_t *dq)
+{
+	long t = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE), b;
+	task_ring_t *ring;
+	task_t *task;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	b = __atomic_load_n(&dq->bottom, __ATOMIC_ACQUIRE);
+	if (t >= b)
+		return (NULL);
+	ring = __atomic_load_n(&dq->ring, __ATOMIC_ACQUIRE);
+	task = __atomic_load_n(ring->slots + (t & (ring->size - 1)),
+			       __ATOMIC_RELAXED);
+	if (!__atomic_compare_exchange_n(&dq->top, &t, t + 1, 0,
+					 __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+		return (NULL);
+	return (task);
+}
+
+/**
+ * task_deque_free - program that frees the slots of a deque, once no
+ * thread uses it anymore; the tasks are not freed
+ * @dq: a pointer to the deque
+ * Return: nothing (void)
+ */
+
+void task_deque_free(task_deque_t *dq)
+{
+	task_ring_t *ring = dq->ring, *prev;
+
+	for (; ring; ring = prev)
+	{
+		prev = ring->prev;
+		free(ring);
+	}
+	dq->ring = NULL;
+	dq->top = dq->bottom = 0;
+}
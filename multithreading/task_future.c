@@ -0,0 +1,170 @@
+#include "multithreading.h"
+
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * struct future_any_s - Futex word of the threads waiting for any task of
+ * a set to complete
+ * there is one word for the whole process, not one per set: while some
+ * thread waits in future_wait_any, every completion, whatever its set and
+ * whether it comes from exec_tasks or a scheduler, wakes every waiter up
+ * @seq:     incremented at every completion while some thread waits
+ * @waiters: number of threads waiting in future_wait_any
+ */
+
+static struct future_any_s
+{
+	unsigned int seq;
+	unsigned int waiters;
+} future_any = {0, 0};
+
+/**
+ * future_deadline - program that computes the deadline of a wait
+ * @deadline: a pointer receiving the deadline, on CLOCK_MONOTONIC
+ * @timeout_ms: the time to wait in milliseconds, ignored if negative
+ * Return: nothing (void)
+ */
+
+static void future_deadline(struct timespec *deadline, long timeout_ms)
+{
+	clock_gettime(CLOCK_MONOTONIC, deadline);
+	if (timeout_ms < 0)
+		return;
+	deadline->tv_sec += timeout_ms / 1000;
+	deadline->tv_nsec += timeout_ms % 1000 * 1000000;
+	deadline->tv_sec += deadline->tv_nsec / 1000000000;
+	deadline->tv_nsec %= 1000000000;
+}
+
+/**
+ * future_futex - program that sleeps on a futex word as long as it holds
+ * a given value, until a deadline
+ * the deadline is absolute, on CLOCK_MONOTONIC, which FUTEX_WAIT_BITSET
+ * takes as it is, so a wake-up that is not for the caller does not push
+ * its deadline back
+ * @word: a pointer to the futex word
+ * @val: the value the word is expected to hold
+ * @deadline: a pointer to the deadline, NULL for none
+ * Return: 0 if the deadline passed, 1 otherwise
+ */
+
+static int future_futex(unsigned int *word, unsigned int val,
+			struct timespec const *deadline)
+{
+	if (syscall(SYS_futex, word, FUTEX_WAIT_BITSET_PRIVATE, val, deadline,
+		    NULL, FUTEX_BITSET_MATCH_ANY) && errno == ETIMEDOUT)
+		return (0);
+	return (1);
+}
+
+/**
+ * future_complete - program that publishes the result of a task and wakes
+ * the threads waiting for it up
+ * the result and the final status, with release semantics for task_wait,
+ * are written before the futex word of the task is swapped to 1; only a
+ * word that was 2 costs a wake-up, and the task is not read after the
+ * swap, so a waiter that sees the task completed may destroy it right away;
+ * a result already written is not written again, as the successors of the
+ * task may be reading it
+ * @task: a pointer to the task
+ * @result: the result of the task, NULL for a failure
+ * Return: nothing (void)
+ */
+
+void future_complete(task_t *task, void *result)
+{
+	if (task->result != result)
+		task->result = result;
+	__atomic_store_n(&task->status, result ? SUCCESS : FAILURE,
+			 __ATOMIC_RELEASE);
+	if (__atomic_exchange_n(&task->futex, 1, __ATOMIC_SEQ_CST) == 2)
+		syscall(SYS_futex, &task->futex, FUTEX_WAKE_PRIVATE, INT_MAX,
+			NULL, NULL, 0);
+	if (__atomic_load_n(&future_any.waiters, __ATOMIC_SEQ_CST))
+	{
+		__atomic_add_fetch(&future_any.seq, 1, __ATOMIC_SEQ_CST);
+		syscall(SYS_futex, &future_any.seq, FUTEX_WAKE_PRIVATE,
+			INT_MAX, NULL, NULL, 0);
+	}
+}
+
+/**
+ * future_timedwait - program that waits for a task to complete, for a
+ * limited time
+ * the caller marks the futex word of the task with 2 and sleeps on it, so
+ * it does not spin; the task completes through future_complete, as
+ * exec_tasks and the work-stealing scheduler do
+ * @task: a pointer to the task
+ * @timeout_ms: the longest time to wait in milliseconds, negative for no
+ *              limit
+ * @result: a pointer receiving the result of the task, may be NULL
+ * Return: 1 if the task completed, 0 if the time ran out
+ */
+
+int future_timedwait(task_t *task, long timeout_ms, void **result)
+{
+	struct timespec deadline;
+	unsigned int word = 0;
+	int alive = 1;
+
+	future_deadline(&deadline, timeout_ms);
+	while (alive && (word = __atomic_load_n(&task->futex,
+						__ATOMIC_ACQUIRE)) != 1)
+	{
+		if (word == 0)
+			__atomic_compare_exchange_n(&task->futex, &word, 2, 0,
+						    __ATOMIC_ACQUIRE,
+						    __ATOMIC_ACQUIRE);
+		alive = future_futex(&task->futex, 2, timeout_ms < 0 ?
+				     NULL : &deadline);
+	}
+	word = __atomic_load_n(&task->futex, __ATOMIC_ACQUIRE);
+	if (word == 1 && result)
+		*result = task->result;
+	return (word == 1);
+}
+
+/**
+ * future_wait_any - program that waits for any task of a set to complete,
+ * for a limited time
+ * the caller sleeps on the futex word of future_any, shared by the whole
+ * process, and looks through its set again whenever any task completes,
+ * so results can be picked up in the order they arrive, at the cost of a
+ * wake-up for every completion outside of the set; a task that completed
+ * before the call is found right away
+ * @tasks: the set of tasks
+ * @n: the number of tasks
+ * @timeout_ms: the longest time to wait in milliseconds, negative for no
+ *              limit
+ * Return: the index of a completed task, or -1 if the time ran out or the
+ *         set is empty
+ */
+
+long future_wait_any(task_t *const *tasks, size_t n, long timeout_ms)
+{
+	struct timespec deadline;
+	unsigned int seq;
+	long found = -1;
+	size_t i;
+	int alive = n > 0;
+
+	future_deadline(&deadline, timeout_ms);
+	__atomic_add_fetch(&future_any.waiters, 1, __ATOMIC_SEQ_CST);
+	while (found < 0 && alive)
+	{
+		seq = __atomic_load_n(&future_any.seq, __ATOMIC_ACQUIRE);
+		for (i = 0; found < 0 && i < n; i++)
+			if (__atomic_load_n(&tasks[i]->futex,
+					    __ATOMIC_SEQ_CST) == 1)
+				found = (long)i;
+		if (found < 0)
+			alive = future_futex(&future_any.seq, seq, timeout_ms <
+					     0 ? NULL : &deadline);
+	}
+	__atomic_sub_fetch(&future_any.waiters, 1, __ATOMIC_RELAXED);
+	return (found);
+}
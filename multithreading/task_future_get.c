@@ -0,0 +1,67 @@
+#include "multithreading.h"
+
+#include <time.h>
+
+/**
+ * future_wait - program that waits for a task to complete
+ * @task: a pointer to the task
+ * Return: the result of the task, NULL if it failed
+ */
+
+void *future_wait(task_t *task)
+{
+	void *result = NULL;
+
+	future_timedwait(task, -1, &result);
+	return (result);
+}
+
+/**
+ * future_try_get - program that gets the result of a task if it completed,
+ * without waiting
+ * @task: a pointer to the task
+ * @result: a pointer receiving the result of the task, may be NULL
+ * Return: 1 if the task completed, 0 otherwise
+ */
+
+int future_try_get(task_t const *task, void **result)
+{
+	if (__atomic_load_n(&task->futex, __ATOMIC_ACQUIRE) != 1)
+		return (0);
+	if (result)
+		*result = task->result;
+	return (1);
+}
+
+/**
+ * future_wait_all - program that waits for every task of a set to
+ * complete, for a limited time
+ * the tasks are waited for one after the other, each one for the time
+ * left before the deadline of the whole set
+ * @tasks: the set of tasks
+ * @n: the number of tasks
+ * @timeout_ms: the longest time to wait in milliseconds, negative for no
+ *              limit
+ * Return: 1 if every task completed, 0 if the time ran out
+ */
+
+int future_wait_all(task_t *const *tasks, size_t n, long timeout_ms)
+{
+	struct timespec t0, t1;
+	long left = timeout_ms;
+	size_t i;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < n; i++)
+	{
+		if (!future_timedwait(tasks[i], left, NULL))
+			return (0);
+		if (timeout_ms < 0)
+			continue;
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		left = timeout_ms - ((t1.tv_sec - t0.tv_sec) * 1000 +
+				     (t1.tv_nsec - t0.tv_nsec) / 1000000);
+		left = left > 0 ? left : 0;
+	}
+	return (1);
+}
@@ -0,0 +1,163 @@
+#include "multithreading.h"
+
+#include <unistd.h>
+
+/**
+ * task_sched_create - program that starts a work-stealing scheduler
+ * every worker owns a Chase-Lev deque (see task_deque_push): the tasks
+ * submitted from a task it runs go to the bottom of its deque and it runs
+ * the newest of them first, while the idle workers steal the oldest ones
+ * from the top of the other deques; the tasks submitted from the other
+ * threads go to a shared inbox the workers steal from too
+ * @nworkers: the number of worker threads; 0 selects the number of online
+ *            processors
+ * Return: a pointer to the scheduler, or NULL on failure
+ */
+
+task_sched_t *task_sched_create(size_t nworkers)
+{
+	long online = sysconf(_SC_NPROCESSORS_ONLN);
+	task_sched_t *sched;
+	task_worker_t *w;
+
+	if (!nworkers)
+		nworkers = online > 0 ? (size_t)online : 1;
+	sched = calloc(1, sizeof(task_sched_t) +
+		       nworkers * sizeof(task_worker_t));
+	if (!sched)
+	{
+		fprintf(stderr, "task_sched_create: out of memory\n");
+		return (NULL);
+	}
+	sched->workers = (task_worker_t *)(sched + 1);
+	sched->nworkers = nworkers;
+	pthread_mutex_init(&sched->inbox_lock, NULL);
+	pthread_mutex_init(&sched->lock, NULL);
+	pthread_cond_init(&sched->wake, NULL);
+	for (; sched->started < nworkers; sched->started++)
+	{
+		w = sched->workers + sched->started;
+		w->sched = sched, w->id = sched->started, w->victim = w->id + 1;
+		if (pthread_create(&w->thread, NULL, task_sched_worker, w))
+		{
+			fprintf(stderr, "task_sched_create: cannot start\n");
+			task_sched_destroy(sched);
+			return (NULL);
+		}
+	}
+	return (sched);
+}
+
+/**
+ * task_sched_destroy - program that stops a work-stealing scheduler
+ * the workers run the tasks still queued before they exit; the tasks
+ * themselves are not destroyed
+ * @sched: a pointer to the scheduler
+ * Return: nothing (void)
+ */
+
+void task_sched_destroy(task_sched_t *sched)
+{
+	size_t i;
+
+	if (!sched)
+		return;
+	pthread_mutex_lock(&sched->lock);
+	__atomic_store_n(&sched->stop, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&sched->epoch, 1, __ATOMIC_RELEASE);
+	pthread_cond_broadcast(&sched->wake);
+	pthread_mutex_unlock(&sched->lock);
+	for (i = 0; i < sched->started; i++)
+		pthread_join(sched->workers[i].thread, NULL);
+	for (i = 0; i < sched->nworkers; i++)
+		task_deque_free(&sched->workers[i].deque);
+	task_deque_free(&sched->inbox);
+	pthread_cond_destroy(&sched->wake);
+	pthread_mutex_destroy(&sched->lock);
+	pthread_mutex_destroy(&sched->inbox_lock);
+	free(sched);
+}
+
+/**
+ * task_sched_wake - program that wakes the threads asleep on a scheduler
+ * up, once a task was pushed or completed
+ * the full fence orders the push or the completion before the read of the
+ * sleepers count, against the increment of that count before the last
+ * look for work of a thread going to sleep (see task_sched_idle): either
+ * the thread sees the work, or the count is seen and the thread woken up;
+ * a push wakes one thread, which runs the task, a completion every thread
+ * waiting for a task, and none if no thread waits
+ * @sched: a pointer to the scheduler
+ * @completed: 1 after a completion, 0 after a push
+ * Return: nothing (void)
+ */
+
+void task_sched_wake(task_sched_t *sched, int completed)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (!__atomic_load_n(completed ? &sched->waiters : &sched->sleepers,
+			     __ATOMIC_RELAXED))
+		return;
+	pthread_mutex_lock(&sched->lock);
+	__atomic_add_fetch(&sched->epoch, 1, __ATOMIC_RELEASE);
+	if (completed)
+		pthread_cond_broadcast(&sched->wake);
+	else
+		pthread_cond_signal(&sched->wake);
+	pthread_mutex_unlock(&sched->lock);
+}
+
+/**
+ * task_sched_run - program that runs a task taken from a deque
+ * the successors of the task are released once its result is written,
+ * so they may read it, and before it is published through
+ * future_complete, after which a waiter may destroy the task; the task
+ * can be waited for with task_wait as well as with the futures, and
+ * submitted again
+ * @sched: a pointer to the scheduler
+ * @task: a pointer to the task
+ * Return: nothing (void)
+ */
+
+void task_sched_run(task_sched_t *sched, task_t *task)
+{
+	void *result;
+
+	__atomic_store_n(&task->status, STARTED, __ATOMIC_RELAXED);
+	result = task->entry(task->param);
+	task->result = result;
+	__atomic_store_n(&task->deps, task->npred + 1, __ATOMIC_RELAXED);
+	task_sched_release(sched, task);
+	future_complete(task, result);
+	task_sched_wake(sched, 1);
+}
+
+/**
+ * task_sched_idle - program that tells whether a thread out of work may
+ * go to sleep, once it counted itself among the sleepers
+ * @sched: a pointer to the scheduler
+ * @waited: a pointer to the task the thread waits for, NULL for a worker
+ * Return: 1 if the waited task is still running and every deque is empty,
+ *         0 otherwise
+ */
+
+int task_sched_idle(task_sched_t *sched, task_t const *waited)
+{
+	task_deque_t const *dq;
+	size_t i;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (waited && __atomic_load_n(&waited->futex, __ATOMIC_ACQUIRE) == 1)
+		return (0);
+	if (!waited && __atomic_load_n(&sched->stop, __ATOMIC_RELAXED))
+		return (0);
+	for (i = 0; i <= sched->nworkers; i++)
+	{
+		dq = i < sched->nworkers ? &sched->workers[i].deque :
+			&sched->inbox;
+		if (__atomic_load_n(&dq->top, __ATOMIC_ACQUIRE) <
+		    __atomic_load_n(&dq->bottom, __ATOMIC_ACQUIRE))
+			return (0);
+	}
+	return (1);
+}
@@ -0,0 +1,147 @@
+#include "multithreading.h"
+
+static __thread task_worker_t *task_self;
+
+/**
+ * task_find - program that looks for a task to run
+ * a worker pops the newest task of its own deque first; then the inbox
+ * and the deques of the workers are stolen from, oldest task first,
+ * starting after the last worker stolen from
+ * @sched: a pointer to the scheduler
+ * @self: a pointer to the calling worker, NULL for another thread
+ * Return: a pointer to the task, or NULL if none was found
+ */
+
+static task_t *task_find(task_sched_t *sched, task_worker_t *self)
+{
+	size_t i, v, n = sched->nworkers;
+	task_t *task = NULL;
+
+	if (self && self->sched == sched)
+		task = task_deque_pop(&self->deque);
+	if (!task)
+		task = task_deque_steal(&sched->inbox);
+	for (i = 0; !task && i < n; i++)
+	{
+		v = self && self->sched == sched ? self->victim++ % n : i;
+		if (!self || self->sched != sched || v != self->id)
+			task = task_deque_steal(&sched->workers[v].deque);
+	}
+	return (task);
+}
+
+/**
+ * task_park - program that puts a thread out of work to sleep until a
+ * task is submitted or completed
+ * the thread counts itself among the sleepers before its last look for
+ * work, and reads the epoch before that look, so a wake-up sent after the
+ * look changes the epoch it sleeps on (see task_sched_wake)
+ * @sched: a pointer to the scheduler
+ * @waited: a pointer to the task the thread waits for, NULL for a worker
+ * Return: nothing (void)
+ */
+
+static void task_park(task_sched_t *sched, task_t const *waited)
+{
+	unsigned long epoch;
+
+	__atomic_add_fetch(&sched->sleepers, 1, __ATOMIC_SEQ_CST);
+	if (waited)
+		__atomic_add_fetch(&sched->waiters, 1, __ATOMIC_SEQ_CST);
+	epoch = __atomic_load_n(&sched->epoch, __ATOMIC_ACQUIRE);
+	if (task_sched_idle(sched, waited))
+	{
+		pthread_mutex_lock(&sched->lock);
+		while (__atomic_load_n(&sched->epoch, __ATOMIC_ACQUIRE) ==
+		       epoch)
+			pthread_cond_wait(&sched->wake, &sched->lock);
+		pthread_mutex_unlock(&sched->lock);
+	}
+	if (waited)
+		__atomic_sub_fetch(&sched->waiters, 1, __ATOMIC_RELAXED);
+	__atomic_sub_fetch(&sched->sleepers, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * task_sched_worker - thread entry program of the workers of a
+ * work-stealing scheduler
+ * a worker runs the tasks it finds, and sleeps when there is none, until
+ * the scheduler stops and no task is left
+ * @arg: a pointer to the task_worker_t of the worker
+ * Return: NULL always
+ */
+
+void *task_sched_worker(void *arg)
+{
+	task_worker_t *self = arg;
+	task_sched_t *sched = self->sched;
+	task_t *task;
+
+	task_self = self;
+	for (; ; )
+	{
+		task = task_find(sched, self);
+		if (task)
+			task_sched_run(sched, task);
+		else if (__atomic_load_n(&sched->stop, __ATOMIC_RELAXED))
+			break;
+		else
+			task_park(sched, NULL);
+	}
+	return (NULL);
+}
+
+/**
+ * task_sched_push - program that queues a task ready to run
+ * a task queued from a task run by a worker of the scheduler, such as a
+ * subtask factoring one half of a range or a successor released by its
+ * last predecessor, goes to the deque of that worker, without any lock; a
+ * task queued from another thread goes to the inbox
+ * @sched: a pointer to the scheduler
+ * @task: a pointer to the task
+ * Return: 1 on success, 0 on failure
+ */
+
+int task_sched_push(task_sched_t *sched, task_t *task)
+{
+	int ok;
+
+	if (task_self && task_self->sched == sched)
+		ok = task_deque_push(&task_self->deque, task);
+	else
+	{
+		pthread_mutex_lock(&sched->inbox_lock);
+		ok = task_deque_push(&sched->inbox, task);
+		pthread_mutex_unlock(&sched->inbox_lock);
+	}
+	if (ok)
+		task_sched_wake(sched, 0);
+	return (ok);
+}
+
+/**
+ * task_wait - program that waits for a submitted task to complete
+ * the waiting thread runs the tasks it finds meanwhile, like a worker, so
+ * a task waiting for its subtasks does not block its worker; it sleeps
+ * when there is none; the task counts as completed once its futex word is
+ * 1, the last write future_complete makes to it, so the caller may
+ * destroy it on return
+ * @sched: a pointer to the scheduler the task was submitted to
+ * @task: a pointer to the task
+ * Return: the result of the task, NULL if it failed
+ */
+
+void *task_wait(task_sched_t *sched, task_t *task)
+{
+	task_t *other;
+
+	while (__atomic_load_n(&task->futex, __ATOMIC_ACQUIRE) != 1)
+	{
+		other = task_find(sched, task_self);
+		if (other)
+			task_sched_run(sched, other);
+		else
+			task_park(sched, task);
+	}
+	return (task->result);
+}
@@ -0,0 +1,121 @@
+#include "test_blur.h"
+
+#define TEST_THREADS 4
+#define TEST_NSHAPES 6
+#define TEST_NSIZES 4
+
+static size_t const test_shapes[TEST_NSHAPES][2] = {
+	{1, 1}, {1, 29}, {29, 1}, {2, 7}, {37, 23}, {61, 47}
+};
+static size_t const test_sizes[TEST_NSIZES] = {1, 3, 5, 9};
+
+/**
+ * run_case - program that checks every blur path on one case
+ * @c: a pointer to the case, its reference blur already computed
+ * Return: 1 if every path matched the reference, 0 otherwise
+ */
+
+static int run_case(blur_case_t const *c)
+{
+	int ok = check_portion(c);
+
+	ok = check_opts(c) && ok;
+	ok = check_fft(c) && ok;
+	ok = check_inplace(c) && ok;
+	ok = check_dirty(c) && ok;
+	ok = check_pipeline(c) && ok;
+	return (check_format(c) && ok);
+}
+
+/**
+ * run_kernel - program that checks every blur path with one kernel on one
+ * image, in every edge mode
+ * @c: a pointer to the case, whose image, output and kernel are set; its
+ *     reference and edge mode are set in turn
+ * @ref: a pointer to the image receiving the reference blur
+ * Return: 1 if every path matched the reference, 0 otherwise
+ */
+
+static int run_kernel(blur_case_t *c, img_t *ref)
+{
+	int ok = 1, edge;
+
+	c->ref = ref;
+	for (edge = EDGE_RENORMALIZE; ok && edge <= EDGE_WRAP; edge++)
+	{
+		c->edge = (edge_mode_t)edge;
+		test_reference(ref, c->img, c->kernel, c->edge);
+		ok = run_case(c);
+	}
+	return (ok);
+}
+
+/**
+ * run_shape - program that checks every blur path on a random image of a
+ * given size, with Gaussian, anisotropic and random kernels of every size
+ * @w: the width of the image
+ * @h: the height of the image
+ * @seed: the seed of the image and of the random kernels
+ * Return: 1 if every path matched the reference, 0 otherwise
+ */
+
+static int run_shape(size_t w, size_t h, unsigned int seed)
+{
+	img_t *img = test_image(w, h, seed), *out = test_image(w, h, 0);
+	img_t *ref = test_image(w, h, 0);
+	kernel_t *kernel;
+	blur_case_t c;
+	size_t size;
+	int ok = img && out && ref, i, kind;
+
+	c.img = img, c.out = out;
+	for (i = 0; ok && i < TEST_NSIZES; i++)
+		for (kind = 0; ok && kind < 3; kind++)
+		{
+			size = test_sizes[i];
+			if (kind < 2)
+				kernel = bench_kernel(size, kind);
+			else
+				kernel = test_kernel(size, seed + i);
+			c.kernel = kernel;
+			ok = kernel && run_kernel(&c, ref);
+			bench_kernel_free(kernel);
+		}
+	bench_image_free(img);
+	bench_image_free(out);
+	bench_image_free(ref);
+	return (ok);
+}
+
+/**
+ * main - behaviour test of the blur paths
+ * the separable, direct, planar, fixed-point, FFT, in-place, incremental,
+ * pipeline and pixel format paths are checked against the reference
+ * direct convolution, on random images including single rows and columns,
+ * with every kernel and edge mode, and again with every instruction set
+ * the CPU supports; the float paths must be within one level of the
+ * reference, which they only differ from by the order of their sums, and
+ * the fixed-point path, which rounds to nearest, too
+ * Return: EXIT_SUCCESS, or EXIT_FAILURE if a check failed
+ */
+
+int main(void)
+{
+	simd_level_t top = blur_simd_level();
+	simd_level_t level;
+	int ok = 1, i;
+
+	blur_pool_init(TEST_THREADS);
+	for (level = SIMD_SCALAR; ok && level <= top; level++)
+	{
+		if (blur_simd_select(level) != level)
+			continue;
+		for (i = 0; ok && i < TEST_NSHAPES; i++)
+			ok = run_shape(test_shapes[i][0], test_shapes[i][1],
+				       level * TEST_NSHAPES + i);
+	}
+	blur_simd_select(top);
+	blur_pool_shutdown();
+	printf("test_blur: %s\n", ok ? "OK" : "FAILED");
+	return (ok ? EXIT_SUCCESS : EXIT_FAILURE);
+}
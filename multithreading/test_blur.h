@@ -0,0 +1,42 @@
+#ifndef TEST_BLUR_H
+#define TEST_BLUR_H
+
+#include "bench.h"
+
+/**
+ * struct blur_case_s - One case of the blur behaviour test
+ * @img:    Source image
+ * @kernel: Convolution kernel
+ * @edge:   Edge mode
+ * @ref:    Reference blur of @img, see test_reference
+ * @out:    Destination image of the path under test, of the size of @img
+ */
+
+typedef struct blur_case_s
+{
+    img_t const *img;
+    kernel_t const *kernel;
+    edge_mode_t edge;
+    img_t const *ref;
+    img_t *out;
+} blur_case_t;
+
+/* test_blur_data.c */
+img_t *test_image(size_t w, size_t h, unsigned int seed);
+kernel_t *test_kernel(size_t size, unsigned int seed);
+void test_reference(img_t *dst, img_t const *src, kernel_t const *kernel,
+		    edge_mode_t edge);
+int test_compare(blur_case_t const *c, char const *path, int tol);
+
+/* test_blur_paths.c */
+int check_portion(blur_case_t const *c);
+int check_opts(blur_case_t const *c);
+int check_fft(blur_case_t const *c);
+int check_inplace(blur_case_t const *c);
+int check_dirty(blur_case_t const *c);
+
+/* test_blur_stages.c */
+int check_pipeline(blur_case_t const *c);
+int check_format(blur_case_t const *c);
+
+#endif /* TEST_BLUR_H */
@@ -0,0 +1,175 @@
+#include "test_blur.h"
+
+#include <string.h>
+
+/**
+ * test_image - program that generates an image of pseudo-random pixels
+ * unlike bench_image, every sample is pure noise over its whole range,
+ * the worst case for the rounding of the blur paths
+ * @w: the width of the image
+ * @h: the height of the image
+ * @seed: the seed of the noise
+ * Return: a pointer to the image, to be released with bench_image_free,
+ *         or NULL on failure
+ */
+
+img_t *test_image(size_t w, size_t h, unsigned int seed)
+{
+	img_t *img = malloc(sizeof(*img));
+	size_t i;
+
+	if (!img)
+		return (NULL);
+	img->w = w, img->h = h;
+	img->pixels = malloc(sizeof(pixel_t) * w * h);
+	if (!img->pixels)
+	{
+		free(img);
+		return (NULL);
+	}
+	for (i = 0; i < w * h; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		img->pixels[i].r = seed >> 8;
+		img->pixels[i].g = seed >> 16;
+		img->pixels[i].b = seed >> 24;
+	}
+	return (img);
+}
+
+/**
+ * test_kernel - program that generates a kernel of pseudo-random weights
+ * the weights are positive, about a quarter of them being zero, so the
+ * kernel is neither separable nor symmetric and has holes; the center
+ * weight is never zero, so that the renormalized weights never add up to
+ * zero
+ * @size: the size of the kernel, odd
+ * @seed: the seed of the weights
+ * Return: a pointer to the kernel, to be released with bench_kernel_free,
+ *         or NULL on failure
+ */
+
+kernel_t *test_kernel(size_t size, unsigned int seed)
+{
+	kernel_t *kernel = malloc(sizeof(*kernel));
+	size_t i, j;
+
+	if (!kernel)
+		return (NULL);
+	kernel->size = size;
+	kernel->matrix = malloc(sizeof(float *) * size +
+				sizeof(float) * size * size);
+	if (!kernel->matrix)
+	{
+		free(kernel);
+		return (NULL);
+	}
+	for (i = 0; i < size; i++)
+	{
+		kernel->matrix[i] = (float *)(kernel->matrix + size) + i * size;
+		for (j = 0; j < size; j++)
+		{
+			seed = seed * 1103515245 + 12345;
+			kernel->matrix[i][j] = (seed >> 16 & 3) ?
+				(seed >> 18 & 1023) / 1024.0f + 0.01f : 0;
+		}
+	}
+	kernel->matrix[size / 2][size / 2] = 1;
+	return (kernel);
+}
+
+/**
+ * ref_pixel - program that blurs one pixel the way the direct blur_portion
+ * did before any of the fast paths: every tap, in kernel row-major order,
+ * accumulated in float and divided by the weights it used
+ * with EDGE_RENORMALIZE the taps falling outside of the image are dropped,
+ * with the other edge modes they read the pixel edge_index maps them to
+ * @src: a pointer to the source image
+ * @kernel: a pointer to the convolution kernel
+ * @edge: the edge mode
+ * @x: the column of the pixel
+ * @y: the row of the pixel
+ * Return: the blurred pixel
+ */
+
+static pixel_t ref_pixel(img_t const *src, kernel_t const *kernel,
+			 edge_mode_t edge, size_t x, size_t y)
+{
+	float r = 0, g = 0, b = 0, total = 0, weight;
+	long sx, sy, half = kernel->size / 2;
+	size_t kx, ky;
+	pixel_t p;
+
+	for (ky = 0; ky < kernel->size; ky++)
+		for (kx = 0; kx < kernel->size; kx++)
+		{
+			sx = (long)(x + kx) - half, sy = (long)(y + ky) - half;
+			if (edge == EDGE_RENORMALIZE &&
+			    (sx < 0 || sx >= (long)src->w ||
+			     sy < 0 || sy >= (long)src->h))
+				continue;
+			p = src->pixels[edge_index(sy, src->h, edge) * src->w +
+					edge_index(sx, src->w, edge)];
+			weight = kernel->matrix[ky][kx];
+			r += p.r * weight, g += p.g * weight, b += p.b * weight;
+			total += weight;
+		}
+	p.r = r / total, p.g = g / total, p.b = b / total;
+	return (p);
+}
+
+/**
+ * test_reference - program that blurs an image with the reference
+ * convolution, see ref_pixel
+ * @dst: a pointer to the destination image, of the size of src
+ * @src: a pointer to the source image
+ * @kernel: a pointer to the convolution kernel
+ * @edge: the edge mode
+ * Return: nothing (void)
+ */
+
+void test_reference(img_t *dst, img_t const *src, kernel_t const *kernel,
+		    edge_mode_t edge)
+{
+	size_t x, y;
+
+	for (y = 0; y < src->h; y++)
+		for (x = 0; x < src->w; x++)
+			dst->pixels[y * dst->w + x] = ref_pixel(src, kernel,
+								edge, x, y);
+}
+
+/**
+ * test_compare - program that compares the output of a blur path with the
+ * reference blur of a case, then scrambles the output, so that a path
+ * that writes nothing cannot pass on the output of the previous one
+ * @c: a pointer to the case
+ * @path: the name of the path, reported on failure
+ * @tol: the largest difference allowed on any sample
+ * Return: 1 if every sample is within tol of the reference, 0 otherwise
+ */
+
+int test_compare(blur_case_t const *c, char const *path, int tol)
+{
+	size_t i, n = c->img->w * c->img->h;
+	int d, worst = 0;
+	pixel_t a, b;
+
+	for (i = 0; i < n; i++)
+	{
+		a = c->out->pixels[i], b = c->ref->pixels[i];
+		d = abs(a.r - b.r);
+		d = abs(a.g - b.g) > d ? abs(a.g - b.g) : d;
+		d = abs(a.b - b.b) > d ? abs(a.b - b.b) : d;
+		worst = d > worst ? d : worst;
+	}
+	memset(c->out->pixels, 0xa5, sizeof(pixel_t) * n);
+	if (worst <= tol)
+		return (1);
+	fprintf(stderr, "test_blur: %s: %lux%lu image, %lux%lu kernel, "
+		"edge %d, simd %d: off by %d\n", path, (unsigned long)c->img->w,
+		(unsigned long)c->img->h, (unsigned long)c->kernel->size,
+		(unsigned long)c->kernel->size, (int)c->edge,
+		(int)blur_simd_level(), worst);
+	return (0);
+}
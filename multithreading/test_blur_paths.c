@@ -0,0 +1,148 @@
+#include "test_blur.h"
+
+#include <string.h>
+
+/**
+ * check_portion - program that checks the single-threaded portion programs
+ * and the portions of blur_image_edge
+ * blur_portion, which always renormalizes, picks the separable or the
+ * direct SIMD convolution on its own; blur_portion_edge and
+ * blur_image_edge honor every edge mode
+ * @c: a pointer to the case
+ * Return: 1 if every path matched the reference, 0 otherwise
+ */
+
+int check_portion(blur_case_t const *c)
+{
+	blur_portion_t p;
+	int ok = 1;
+
+	p.img = c->img, p.img_blur = c->out, p.x = 0, p.y = 0;
+	p.w = c->img->w, p.h = c->img->h, p.kernel = c->kernel;
+	p.edge = c->edge;
+	if (c->edge == EDGE_RENORMALIZE)
+	{
+		blur_portion(&p);
+		ok = test_compare(c, "blur_portion", 1);
+	}
+	blur_portion_edge(&p, c->edge);
+	ok = test_compare(c, "blur_portion_edge", 1) && ok;
+	blur_image_edge(c->out, c->img, c->kernel, c->edge);
+	return (test_compare(c, "blur_image_edge", 1) && ok);
+}
+
+/**
+ * check_opts - program that checks blur_image_opts with automatic and
+ * small tiles, through the planar layout and in fixed point
+ * the fixed-point path rounds to nearest where the reference truncates,
+ * so it is within one level too
+ * @c: a pointer to the case
+ * Return: 1 if every path matched the reference, 0 otherwise
+ */
+
+int check_opts(blur_case_t const *c)
+{
+	static char const *const names[] = {
+		"tiles", "small tiles", "planar", "fixed", "fixed small tiles"
+	};
+	blur_opts_t opts;
+	int ok = 1, i;
+
+	for (i = 0; i < 5; i++)
+	{
+		memset(&opts, 0, sizeof(opts));
+		opts.edge = c->edge;
+		opts.tile_w = i % 3 == 1 ? 5 : 0;
+		opts.tile_h = i % 3 == 1 ? 3 : 0;
+		opts.planar = i == 2, opts.fixed = i >= 3;
+		blur_image_opts(c->out, c->img, c->kernel, &opts);
+		ok = test_compare(c, names[i], 1) && ok;
+	}
+	return (ok);
+}
+
+/**
+ * check_fft - program that checks the FFT convolution, called directly so
+ * that it runs on every kernel and not only on those blur_image_ck finds
+ * cheaper to convolve in the frequency domain
+ * @c: a pointer to the case
+ * Return: 1 if the path matched the reference, 0 otherwise
+ */
+
+int check_fft(blur_case_t const *c)
+{
+	ckernel_t *ck = kernel_compile(c->kernel);
+	blur_opts_t opts;
+	int ok;
+
+	memset(&opts, 0, sizeof(opts));
+	opts.edge = c->edge;
+	ok = ck && blur_image_fft(c->out, c->img, ck, &opts);
+	kernel_free(ck);
+	return (test_compare(c, "blur_image_fft", 1) && ok);
+}
+
+/**
+ * check_inplace - program that checks the in-place blur, in float and in
+ * fixed point
+ * @c: a pointer to the case
+ * Return: 1 if every path matched the reference, 0 otherwise
+ */
+
+int check_inplace(blur_case_t const *c)
+{
+	size_t n = c->img->w * c->img->h;
+	blur_opts_t opts;
+	char const *name;
+	int ok = 1, fixed, done;
+
+	memset(&opts, 0, sizeof(opts));
+	opts.edge = c->edge;
+	for (fixed = 0; fixed < 2; fixed++)
+	{
+		opts.fixed = fixed;
+		memcpy(c->out->pixels, c->img->pixels, sizeof(pixel_t) * n);
+		done = blur_image_inplace(c->out, c->kernel, &opts);
+		name = fixed ? "fixed in-place" : "in-place";
+		ok = test_compare(c, name, 1) && done && ok;
+	}
+	return (ok);
+}
+
+/**
+ * check_dirty - program that checks the incremental blur
+ * the output starts as the reference blur of a copy of the source whose
+ * middle third was inverted; re-blurring that rectangle must give the
+ * blur of the source itself
+ * @c: a pointer to the case
+ * Return: 1 if the path matched the reference, 0 otherwise
+ */
+
+int check_dirty(blur_case_t const *c)
+{
+	img_t *old = test_image(c->img->w, c->img->h, 0);
+	rect_t dirty;
+	blur_opts_t opts;
+	size_t x, y;
+	pixel_t *p;
+	int ok;
+
+	if (!old)
+		return (0);
+	memcpy(old->pixels, c->img->pixels,
+	       sizeof(pixel_t) * c->img->w * c->img->h);
+	dirty.x = old->w / 3, dirty.w = (old->w + 2) / 3;
+	dirty.y = old->h / 3, dirty.h = (old->h + 2) / 3;
+	for (y = dirty.y; y < dirty.y + dirty.h; y++)
+		for (x = dirty.x; x < dirty.x + dirty.w; x++)
+		{
+			p = old->pixels + y * old->w + x;
+			p->r = ~p->r, p->g = ~p->g, p->b = ~p->b;
+		}
+	test_reference(c->out, old, c->kernel, c->edge);
+	bench_image_free(old);
+	memset(&opts, 0, sizeof(opts));
+	opts.edge = c->edge;
+	ok = blur_image_dirty(c->out, c->img, c->kernel, &opts, &dirty, 1);
+	return (test_compare(c, "blur_image_dirty", 1) && ok);
+}
@@ -0,0 +1,147 @@
+#include "test_blur.h"
+
+#include <string.h>
+
+/**
+ * check_pipeline - program that checks the fused pipeline with one stage,
+ * and with two stages against the reference blur applied twice
+ * every stage may be one level off, and the second stage carries the
+ * error of the first one, so two stages are within two levels
+ * @c: a pointer to the case
+ * Return: 1 if every path matched the reference, 0 otherwise
+ */
+
+int check_pipeline(blur_case_t const *c)
+{
+	kernel_t const *kernels[2];
+	img_t *twice = test_image(c->img->w, c->img->h, 0);
+	blur_case_t two = *c;
+	blur_opts_t opts;
+	int ok;
+
+	if (!twice)
+		return (0);
+	kernels[0] = kernels[1] = c->kernel;
+	memset(&opts, 0, sizeof(opts));
+	opts.edge = c->edge;
+	ok = blur_pipeline(c->out, c->img, kernels, 1, &opts);
+	ok = test_compare(c, "blur_pipeline", 1) && ok;
+	test_reference(twice, c->ref, c->kernel, c->edge);
+	two.ref = twice;
+	ok = blur_pipeline(c->out, c->img, kernels, 2, &opts) && ok;
+	ok = test_compare(&two, "blur_pipeline, two stages", 2) && ok;
+	bench_image_free(twice);
+	return (ok);
+}
+
+/**
+ * format_pack - program that copies an 8-bit image into an image of
+ * another pixel format, the samples keeping their values; the alpha of
+ * PIXEL_RGBA8 is the green sample
+ * @dst: a pointer to the image of the other format, of the size of src
+ * @src: a pointer to the 8-bit image
+ * Return: nothing (void)
+ */
+
+static void format_pack(fimg_t *dst, img_t const *src)
+{
+	size_t i, n = src->w * src->h;
+	pixel_t const *p = src->pixels;
+	uint8_t *b;
+	uint16_t *s;
+	float *f;
+
+	for (i = 0; i < n; i++, p++)
+		if (dst->format == PIXEL_RGB8)
+			((pixel_t *)dst->pixels)[i] = *p;
+		else if (dst->format == PIXEL_RGBA8)
+		{
+			b = (uint8_t *)dst->pixels + 4 * i;
+			b[0] = p->r, b[1] = p->g, b[2] = p->b, b[3] = p->g;
+		}
+		else if (dst->format == PIXEL_RGB16)
+		{
+			s = (uint16_t *)dst->pixels + 3 * i;
+			s[0] = p->r, s[1] = p->g, s[2] = p->b;
+		}
+		else
+		{
+			f = (float *)dst->pixels + 3 * i;
+			f[0] = p->r, f[1] = p->g, f[2] = p->b;
+		}
+}
+
+/**
+ * format_unpack - program that copies an image of any pixel format back
+ * into an 8-bit image, truncating the float samples
+ * @dst: a pointer to the 8-bit image, of the size of src
+ * @src: a pointer to the image of the other format
+ * Return: 1, or 0 if an alpha sample differs from its green sample, both
+ *         having been blurred alike
+ */
+
+static int format_unpack(img_t *dst, fimg_t const *src)
+{
+	size_t i, n = src->w * src->h;
+	pixel_t *p = dst->pixels;
+	uint8_t const *b;
+	uint16_t const *s;
+	float const *f;
+	int ok = 1;
+
+	for (i = 0; i < n; i++, p++)
+		if (src->format == PIXEL_RGB8)
+			*p = ((pixel_t const *)src->pixels)[i];
+		else if (src->format == PIXEL_RGBA8)
+		{
+			b = (uint8_t const *)src->pixels + 4 * i;
+			p->r = b[0], p->g = b[1], p->b = b[2];
+			ok = ok && b[3] == b[1];
+		}
+		else if (src->format == PIXEL_RGB16)
+		{
+			s = (uint16_t const *)src->pixels + 3 * i;
+			p->r = s[0], p->g = s[1], p->b = s[2];
+		}
+		else
+		{
+			f = (float const *)src->pixels + 3 * i;
+			p->r = f[0], p->g = f[1], p->b = f[2];
+		}
+	return (ok);
+}
+
+/**
+ * check_format - program that checks blur_image_format on every pixel
+ * format, the samples of the wider formats holding 8-bit values
+ * @c: a pointer to the case
+ * Return: 1 if every format matched the reference, 0 otherwise
+ */
+
+int check_format(blur_case_t const *c)
+{
+	static char const *const names[] = {
+		"format rgb8", "format rgba8", "format rgb16", "format rgbf"
+	};
+	size_t size = pixel_format_size(PIXEL_RGBF) * c->img->w * c->img->h;
+	fimg_t in, out;
+	blur_opts_t opts;
+	int ok = 1, i, done;
+
+	in.w = out.w = c->img->w, in.h = out.h = c->img->h;
+	in.pixels = malloc(size), out.pixels = malloc(size);
+	memset(&opts, 0, sizeof(opts));
+	opts.edge = c->edge;
+	for (i = PIXEL_RGB8; in.pixels && out.pixels && i <= PIXEL_RGBF; i++)
+	{
+		in.format = out.format = (pixel_format_t)i;
+		format_pack(&in, c->img);
+		done = blur_image_format(&out, &in, c->kernel, &opts);
+		done = format_unpack(c->out, &out) && done;
+		ok = test_compare(c, names[i], 1) && done && ok;
+	}
+	ok = ok && in.pixels && out.pixels;
+	free(in.pixels);
+	free(out.pixels);
+	return (ok);
+}
@@ -0,0 +1,146 @@
+#include "multithreading.h"
+
+#define DAG_WORKERS 4
+#define DAG_ROUNDS 200
+
+/**
+ * struct dag_node_s - Task of the diamond graph of the test
+ * @task:   the task running the node
+ * @pred:   the predecessors of the node
+ * @npred:  the number of predecessors
+ * @stamp:  the tick of the clock the node started at, 0 if it did not
+ * @failed: whether the node fails, returning NULL
+ * @seen:   number of predecessors whose outcome the node saw, a failed
+ *          one counting if its result was NULL, another one if it was not
+ */
+
+typedef struct dag_node_s
+{
+	task_t *task;
+	struct dag_node_s *pred[2];
+	size_t npred;
+	unsigned long stamp;
+	int failed;
+	size_t seen;
+} dag_node_t;
+
+static unsigned long dag_clock;
+
+/**
+ * dag_task - task entry program of a node of the graph
+ * the node takes a tick of the clock and looks at the results of its
+ * predecessors, which must have completed before it started
+ * @arg: a pointer to the dag_node_t
+ * Return: the list of the prime factors of 6, or NULL if the node fails
+ */
+
+static void *dag_task(void *arg)
+{
+	dag_node_t *node = arg, *p;
+	size_t i;
+
+	node->stamp = __atomic_add_fetch(&dag_clock, 1, __ATOMIC_RELAXED);
+	for (node->seen = 0, i = 0; i < node->npred; i++)
+	{
+		p = node->pred[i];
+		if (p->stamp && p->stamp < node->stamp &&
+		    (p->task->result == NULL) == p->failed)
+			node->seen++;
+	}
+	return (node->failed ? NULL : prime_factors("6"));
+}
+
+/**
+ * dag_round - program that submits the diamond graph, in reverse order,
+ * and checks that every node ran after its predecessors
+ * @sched: a pointer to the scheduler
+ * @nodes: the four nodes of the diamond, the source first
+ * Return: 1 if every check passed, 0 otherwise
+ */
+
+static int dag_round(task_sched_t *sched, dag_node_t *nodes)
+{
+	int ok = 1, i;
+
+	for (i = 0; i < 4; i++)
+		nodes[i].stamp = 0;
+	for (i = 3; i >= 0; i--)
+		ok = ok && task_submit(sched, nodes[i].task);
+	for (i = 0; ok && i < 4; i++)
+	{
+		task_wait(sched, nodes[i].task);
+		ok = nodes[i].stamp && nodes[i].seen == nodes[i].npred;
+		ok = ok && nodes[i].task->status ==
+			(nodes[i].failed ? FAILURE : SUCCESS);
+	}
+	return (ok);
+}
+
+/**
+ * dag_exec - program that checks that exec_tasks leaves the tasks that
+ * have predecessors alone
+ * Return: 1 if the dependent task was skipped while the other one ran,
+ *         0 otherwise
+ */
+
+static int dag_exec(void)
+{
+	dag_node_t node = {NULL, {NULL, NULL}, 0, 0, 0, 0};
+	task_t *source = create_task(dag_task, &node);
+	task_t *dep = create_task(dag_task, &node);
+	task_t *other = create_task(dag_task, &node);
+	list_t list;
+	int ok;
+
+	list_init(&list);
+	ok = source && dep && other && task_depend(dep, source) &&
+		list_add(&list, dep) && list_add(&list, other);
+	if (ok)
+		exec_tasks(&list);
+	ok = ok && dep->status == PENDING && other->status == SUCCESS;
+	list_destroy(&list, NULL);
+	destroy_task(source);
+	destroy_task(dep);
+	destroy_task(other);
+	return (ok);
+}
+
+/**
+ * main - test of the task dependencies
+ * a diamond graph, a source feeding two branches joined by a sink, is
+ * submitted again and again, one branch failing every other round: the
+ * branches and the sink must start after their predecessors, the sink
+ * still running after a failed branch; exec_tasks must skip the tasks that
+ * have predecessors
+ * Return: EXIT_SUCCESS, or EXIT_FAILURE if a check failed
+ */
+
+int main(void)
+{
+	task_sched_t *sched = task_sched_create(DAG_WORKERS);
+	dag_node_t nodes[4];
+	int ok = sched != NULL, i;
+
+	for (i = 0; i < 4; i++)
+	{
+		nodes[i].task = create_task(dag_task, nodes + i);
+		nodes[i].npred = i == 0 ? 0 : i < 3 ? 1 : 2;
+		nodes[i].pred[0] = i < 3 ? nodes : nodes + 1;
+		nodes[i].pred[1] = nodes + 2, nodes[i].failed = 0;
+		ok = ok && nodes[i].task;
+	}
+	for (i = 1; ok && i < 4; i++)
+		ok = task_depend(nodes[i].task, nodes[i].pred[0]->task) &&
+			(i < 3 || task_depend(nodes[i].task, nodes[2].task));
+	for (i = 0; ok && i < DAG_ROUNDS; i++)
+	{
+		nodes[1].failed = i % 2;
+		ok = dag_round(sched, nodes);
+	}
+	ok = ok && dag_exec();
+	task_sched_destroy(sched);
+	for (i = 0; i < 4; i++)
+		destroy_task(nodes[i].task);
+	printf("test_dag: %s\n", ok ? "OK" : "FAILED");
+	return (ok ? EXIT_SUCCESS : EXIT_FAILURE);
+}
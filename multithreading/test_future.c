@@ -0,0 +1,118 @@
+#include "multithreading.h"
+
+#include <time.h>
+
+#define FUTURE_TASKS 4
+#define FUTURE_TIMEOUT_MS 50
+
+static int gates[FUTURE_TASKS];
+
+/**
+ * gate_task - task entry program that waits for its gate to open, then
+ * factors a small number
+ * @arg: the index of the gate, cast to a pointer
+ * Return: the list of the prime factors of the index plus two
+ */
+
+static void *gate_task(void *arg)
+{
+	size_t i = (size_t)arg;
+	struct timespec nap = {0, 100000};
+	char buf[32];
+
+	while (!__atomic_load_n(gates + i, __ATOMIC_ACQUIRE))
+		nanosleep(&nap, NULL);
+	sprintf(buf, "%lu", (unsigned long)i + 2);
+	return (prime_factors(buf));
+}
+
+/**
+ * check_pending - program that checks the waits on a task still running
+ * the timed wait must run out after its timeout, and neither try-get nor
+ * wait-any may find the task completed
+ * @task: a pointer to the task, whose gate is closed
+ * Return: 1 if every check passed, 0 otherwise
+ */
+
+static int check_pending(task_t *task)
+{
+	struct timespec t0, t1;
+	void *result = NULL;
+	long ms;
+	int ok;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	ok = !future_timedwait(task, FUTURE_TIMEOUT_MS, &result) && !result;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	ms = (t1.tv_sec - t0.tv_sec) * 1000 +
+	     (t1.tv_nsec - t0.tv_nsec) / 1000000;
+	ok = ok && ms >= FUTURE_TIMEOUT_MS - 1;
+	ok = ok && !future_try_get(task, &result) && !result;
+	ok = ok && future_wait_any(&task, 1, FUTURE_TIMEOUT_MS) == -1;
+	return (ok && future_wait_any(NULL, 0, 0) == -1);
+}
+
+/**
+ * check_order - program that opens the gates of a set of tasks one at a
+ * time and checks that future_wait_any returns them in that order, and
+ * that try-get then finds their result
+ * @tasks: the tasks, their gates closed
+ * @order: the order the gates are opened in
+ * Return: 1 if every check passed, 0 otherwise
+ */
+
+static int check_order(task_t **tasks, size_t const *order)
+{
+	task_t *left[FUTURE_TASKS];
+	size_t n = FUTURE_TASKS, i;
+	void *result = NULL;
+	long k;
+	int ok = 1;
+
+	for (i = 0; i < n; i++)
+		left[i] = tasks[i];
+	for (i = 0; ok && i < FUTURE_TASKS; i++)
+	{
+		__atomic_store_n(gates + order[i], 1, __ATOMIC_RELEASE);
+		k = future_wait_any(left, n, 5000);
+		ok = k >= 0 && left[k] == tasks[order[i]];
+		ok = ok && future_try_get(left[k], &result) && result &&
+			result == left[k]->result;
+		if (ok)
+			left[k] = left[--n];
+	}
+	return (ok && future_wait_all(tasks, FUTURE_TASKS, 0));
+}
+
+/**
+ * main - test of the futures over task_t
+ * a timed-out wait, try-get before and after completion and wait-any
+ * returning the tasks in the order they complete are checked over tasks
+ * run by a work-stealing scheduler, held back by gates
+ * Return: EXIT_SUCCESS, or EXIT_FAILURE if a check failed
+ */
+
+int main(void)
+{
+	static size_t const order[FUTURE_TASKS] = {2, 0, 3, 1};
+	task_sched_t *sched = task_sched_create(FUTURE_TASKS);
+	task_t *tasks[FUTURE_TASKS];
+	size_t i;
+	int ok = sched != NULL;
+
+	for (i = 0; i < FUTURE_TASKS; i++)
+	{
+		tasks[i] = create_task(gate_task, (void *)i);
+		ok = ok && tasks[i] && task_submit(sched, tasks[i]);
+	}
+	ok = ok && check_pending(tasks[order[0]]);
+	if (ok)
+		ok = check_order(tasks, order);
+	for (i = 0; i < FUTURE_TASKS; i++)
+		__atomic_store_n(gates + i, 1, __ATOMIC_RELEASE);
+	task_sched_destroy(sched);
+	for (i = 0; i < FUTURE_TASKS; i++)
+		destroy_task(tasks[i]);
+	printf("test_future: %s\n", ok ? "OK" : "FAILED");
+	return (ok ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,181 @@
+#include "multithreading.h"
+
+#define SCHED_WORKERS 16
+#define SCHED_ROUNDS 8
+#define SCHED_FIRST 2
+#define SCHED_COUNT 30000
+#define SCHED_LEAF 16
+
+/**
+ * struct range_s - Range of numbers factored by a task and its subtasks
+ * @sched: the scheduler the subtasks are submitted to
+ * @lo:    the first number of the range
+ * @hi:    the number past the last one
+ */
+
+typedef struct range_s
+{
+	task_sched_t *sched;
+	unsigned long lo;
+	unsigned long hi;
+} range_t;
+
+static unsigned int runs[SCHED_COUNT];
+static unsigned long nruns;
+static unsigned long nbad;
+
+static void *range_task(void *arg);
+
+/**
+ * range_leaf - program that factors every number of a small range, checks
+ * the factors against the number and counts the run of every number
+ * @r: a pointer to the range
+ * Return: the number of prime factors of the range
+ */
+
+static unsigned long range_leaf(range_t const *r)
+{
+	unsigned long n, p, count = 0;
+	char buf[32];
+	list_t *factors;
+	node_t *node;
+
+	for (n = r->lo; n < r->hi; n++)
+	{
+		__atomic_add_fetch(runs + n - SCHED_FIRST, 1, __ATOMIC_RELAXED);
+		sprintf(buf, "%lu", n);
+		factors = prime_factors(buf);
+		if (!factors)
+		{
+			__atomic_add_fetch(&nbad, 1, __ATOMIC_RELAXED);
+			continue;
+		}
+		for (p = 1, node = factors->head; node; node = node->next)
+			p *= *(unsigned long *)node->content;
+		if (p != n)
+			__atomic_add_fetch(&nbad, 1, __ATOMIC_RELAXED);
+		count += factors->size;
+		list_destroy(factors, free);
+		free(factors);
+	}
+	return (count);
+}
+
+/**
+ * range_split - program that splits a range in two subtasks, submits them
+ * from the task running on a worker and waits for both, running other
+ * tasks meanwhile
+ * @r: a pointer to the range
+ * Return: the number of prime factors of the range
+ */
+
+static unsigned long range_split(range_t const *r)
+{
+	range_t sub[2];
+	task_t *t[2];
+	list_t *res;
+	unsigned long count = 0;
+	int i;
+
+	sub[0] = sub[1] = *r;
+	sub[0].hi = sub[1].lo = r->lo + (r->hi - r->lo) / 2;
+	for (i = 0; i < 2; i++)
+	{
+		t[i] = create_task(range_task, sub + i);
+		if (t[i] && !task_submit(r->sched, t[i]))
+			destroy_task(t[i]), t[i] = NULL;
+	}
+	for (i = 0; i < 2; i++)
+	{
+		res = t[i] ? task_wait(r->sched, t[i]) : NULL;
+		if (res)
+			count += *(unsigned long *)res->head->content;
+		else
+			__atomic_add_fetch(&nbad, 1, __ATOMIC_RELAXED);
+		destroy_task(t[i]);
+	}
+	return (count);
+}
+
+/**
+ * range_task - task entry program that factors a range of numbers,
+ * directly if it is small and through two subtasks otherwise
+ * @arg: a pointer to the range_t
+ * Return: a list holding the number of prime factors of the range, or
+ *         NULL on failure
+ */
+
+static void *range_task(void *arg)
+{
+	range_t const *r = arg;
+	unsigned long *count = malloc(sizeof(*count));
+	list_t *res = malloc(sizeof(*res));
+
+	__atomic_add_fetch(&nruns, 1, __ATOMIC_RELAXED);
+	if (!count || !res || !list_add(list_init(res), count))
+	{
+		free(count);
+		free(res);
+		return (NULL);
+	}
+	*count = r->hi - r->lo > SCHED_LEAF ? range_split(r) : range_leaf(r);
+	return (res);
+}
+
+/**
+ * range_ntasks - program that counts the tasks of the tree factoring a
+ * range, the way range_task splits it
+ * @lo: the first number of the range
+ * @hi: the number past the last one
+ * Return: the number of tasks
+ */
+
+static unsigned long range_ntasks(unsigned long lo, unsigned long hi)
+{
+	unsigned long mid = lo + (hi - lo) / 2;
+
+	if (hi - lo <= SCHED_LEAF)
+		return (1);
+	return (1 + range_ntasks(lo, mid) + range_ntasks(mid, hi));
+}
+
+/**
+ * main - stress test of the work-stealing scheduler
+ * every round factors a range of numbers through a tree of subtasks
+ * spawned from the workers, then checks that every number was factored
+ * exactly once, that every task of the tree ran exactly once and that the
+ * factors add up to those found sequentially
+ * Return: EXIT_SUCCESS, or EXIT_FAILURE if a check failed
+ */
+
+int main(void)
+{
+	task_sched_t *sched = task_sched_create(SCHED_WORKERS);
+	unsigned long expected = 0, ntasks, round, i;
+	range_t root;
+	task_t *task;
+	list_t *res;
+	int ok = sched != NULL;
+
+	root.sched = sched, root.lo = SCHED_FIRST;
+	root.hi = SCHED_FIRST + SCHED_COUNT;
+	expected = range_leaf(&root);
+	ntasks = range_ntasks(root.lo, root.hi);
+	for (round = 0; ok && round < SCHED_ROUNDS; round++)
+	{
+		nruns = 0;
+		for (i = 0; i < SCHED_COUNT; i++)
+			runs[i] = 0;
+		task = create_task(range_task, &root);
+		ok = task && task_submit(sched, task);
+		res = ok ? task_wait(sched, task) : NULL;
+		ok = res && *(unsigned long *)res->head->content == expected;
+		for (i = 0; ok && i < SCHED_COUNT; i++)
+			ok = runs[i] == 1;
+		ok = ok && !nbad && nruns == ntasks;
+		destroy_task(task);
+	}
+	task_sched_destroy(sched);
+	printf("test_sched: %s\n", ok ? "OK" : "FAILED");
+	return (ok ? EXIT_SUCCESS : EXIT_FAILURE);
+}